@@ -0,0 +1,98 @@
+#include "AdaptiveVolumeQuality.h"
+
+#include <vtkGPUVolumeRayCastMapper.h>
+#include <vtkObjectFactory.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+#include <vtkRenderer.h>
+
+#include <algorithm>
+#include <cmath>
+
+vtkStandardNewMacro(AdaptiveVolumeQuality);
+
+namespace {
+// Coarser than this the volume is no longer recognizable, better drop frames
+constexpr double MinimumQuality = 1.0 / 64;
+constexpr double MaximumImageSampleDistance = 4.0;
+}
+
+AdaptiveVolumeQuality::~AdaptiveVolumeQuality()
+{
+    this->Observe(nullptr, nullptr, this->FullQualitySampleDistance);
+}
+
+void AdaptiveVolumeQuality::Observe(vtkRenderer* renderer, vtkGPUVolumeRayCastMapper* mapper, double fullQualitySampleDistance)
+{
+    if (this->Renderer) {
+        this->Renderer->RemoveObserver(this->StartObserver);
+        this->Renderer->RemoveObserver(this->EndObserver);
+    }
+    if (this->Timer) {
+        // note: With the context current, this is called from the thread that renders or on destruction of the VTK objects
+        this->Timer->ReleaseGraphicsResources();
+        this->Timer.reset();
+    }
+    this->Renderer = renderer;
+    this->Mapper = mapper;
+    this->FullQualitySampleDistance = fullQualitySampleDistance;
+    this->Interactive = false;
+    if (renderer) {
+        this->StartObserver = renderer->AddObserver(vtkCommand::StartEvent, this);
+        this->EndObserver = renderer->AddObserver(vtkCommand::EndEvent, this);
+    }
+    if (mapper) {
+        // We do the adjusting, with the measured times rather than the mapper's estimates
+        mapper->AutoAdjustSampleDistancesOff();
+        mapper->LockSampleDistanceToInputSpacingOff();
+        this->Apply(1.0);
+    }
+}
+
+void AdaptiveVolumeQuality::Execute(vtkObject*, unsigned long eventId, void*)
+{
+    auto window = this->Renderer ? this->Renderer->GetRenderWindow() : nullptr;
+    if (!this->Mapper || !window)
+        return;
+
+    if (eventId == vtkCommand::StartEvent) {
+        auto interactor = window->GetInteractor();
+        const bool interactive = interactor && window->GetDesiredUpdateRate() > interactor->GetStillUpdateRate();
+        if (interactive && !this->Interactive)
+            this->FramesTimed = 0;
+        this->Interactive = interactive;
+        this->Apply(this->Interactive ? this->InteractiveQuality : 1.0);
+
+        if (!this->Interactive)
+            return;
+        if (!this->Timer && vtkOpenGLRenderTimer::IsSupported())
+            this->Timer.reset(new vtkOpenGLRenderTimer);
+        if (this->Timer)
+            this->Timer->ReusableStart();
+    } else if (eventId == vtkCommand::EndEvent && this->Interactive && this->Timer) {
+        // The ray casting runs on the GPU, its time is only known a frame or two later and we don't wait for it
+        this->Timer->ReusableStop();
+        const double seconds = this->Timer->GetReusableElapsedSeconds();
+
+        // Until the queries of this interaction come back, the result is of the previous one or none at all
+        if (++this->FramesTimed <= 2 || seconds <= 0)
+            return;
+        const double budget = 1.0 / window->GetDesiredUpdateRate();
+
+        // The cost is about proportional to the quality, damp the correction so that noise (and the lag) doesn't make it flicker
+        const double correction = std::pow(budget / std::max(seconds, 1e-4), 0.7);
+        this->InteractiveQuality = std::clamp(this->InteractiveQuality * correction, MinimumQuality, 1.0);
+    }
+}
+
+void AdaptiveVolumeQuality::Apply(double quality)
+{
+    // The cost goes with the samples along each ray times the number of rays, coarsen both alike
+    const double coarsening = std::cbrt(1.0 / quality);
+    // In half pixel steps, the mapper reallocates its reduced size framebuffer on every new image sample distance
+    const double imageSampleDistance = std::clamp(std::round(2 * coarsening) / 2, 1.0, MaximumImageSampleDistance);
+    const double sampleDistance = this->FullQualitySampleDistance * std::max(1.0, 1.0 / (quality * imageSampleDistance * imageSampleDistance));
+
+    this->Mapper->SetImageSampleDistance(imageSampleDistance);
+    this->Mapper->SetSampleDistance(sampleDistance);
+}
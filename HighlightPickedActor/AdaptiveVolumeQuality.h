@@ -0,0 +1,66 @@
+#ifndef ADAPTIVEVOLUMEQUALITY_H
+#define ADAPTIVEVOLUMEQUALITY_H
+
+#include <vtkCommand.h>
+#include <vtkOpenGLRenderTimer.h>
+#include <vtkWeakPointer.h>
+
+#include <memory>
+
+class vtkGPUVolumeRayCastMapper;
+class vtkRenderer;
+
+/**
+* Trades volume rendering quality for frame rate while interacting, and goes back to full quality when still.
+*
+* While the render window renders at an interactive DesiredUpdateRate (set by the interactor style between
+* StartInteraction and EndInteraction), the sample distance and the image sample distance of the mapper are
+* coarsened so that the measured frame time meets the budget of 1 / DesiredUpdateRate.  At the StillUpdateRate
+* the mapper renders with the full quality sample distance.  The quality learned is kept for the next interaction.
+*
+*   vtkNew<AdaptiveVolumeQuality> quality;
+*   quality->Observe(renderer, mapper, 0.5 * spacing);
+*
+* \note The frame time is the GPU time of the renderer (ray casting is all GPU work), measured with a GL timer query
+*       read back a frame or two late, so it never waits for the GPU.  Nothing is measured when still.
+*
+* \note Works with any renderer, the demo item only hooks it up to the volume of MyVtkItem
+*/
+class AdaptiveVolumeQuality : public vtkCommand
+{
+public:
+    static AdaptiveVolumeQuality* New();
+    vtkTypeMacro(AdaptiveVolumeQuality, vtkCommand);
+
+    // Observe the renders of 'renderer' and adapt 'mapper', stops observing the previous renderer if any
+    void Observe(vtkRenderer* renderer, vtkGPUVolumeRayCastMapper* mapper, double fullQualitySampleDistance);
+
+    // The fraction of the full quality cost used while interacting, 1 is full quality
+    double GetInteractiveQuality() const { return this->InteractiveQuality; }
+
+    void Execute(vtkObject* caller, unsigned long eventId, void* callData) override;
+
+protected:
+    AdaptiveVolumeQuality() = default;
+    ~AdaptiveVolumeQuality() override;
+
+private:
+    void Apply(double quality);
+
+    vtkWeakPointer<vtkRenderer> Renderer;
+    vtkWeakPointer<vtkGPUVolumeRayCastMapper> Mapper;
+    unsigned long StartObserver = 0;
+    unsigned long EndObserver = 0;
+    double FullQualitySampleDistance = 1.0;
+    double InteractiveQuality = 1.0;
+    bool Interactive = false;
+
+    // Only used with the OpenGL context current, in the render events
+    std::unique_ptr<vtkOpenGLRenderTimer> Timer;
+    int FramesTimed = 0;                // of this interaction
+
+    AdaptiveVolumeQuality(const AdaptiveVolumeQuality&) = delete;
+    void operator=(const AdaptiveVolumeQuality&) = delete;
+};
+
+#endif // ADAPTIVEVOLUMEQUALITY_H
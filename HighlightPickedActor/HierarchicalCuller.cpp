@@ -0,0 +1,367 @@
+#include "HierarchicalCuller.h"
+#include "QQuickVtkTrace.h"
+
+#include <vtkCamera.h>
+#include <vtkFloatArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkProp.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+vtkStandardNewMacro(HierarchicalCuller);
+
+namespace {
+constexpr int LeafSize = 8;
+constexpr int TileSize = 16;            // pixels
+constexpr int AllPlanes = 0x3f;
+
+void unite(double* bounds, const double* other)
+{
+    for (int i = 0; i < 6; i += 2) {
+        bounds[i] = std::min(bounds[i], other[i]);
+        bounds[i + 1] = std::max(bounds[i + 1], other[i + 1]);
+    }
+}
+
+void emptyBounds(double* bounds)
+{
+    for (int i = 0; i < 6; i += 2) {
+        bounds[i] = std::numeric_limits<double>::max();
+        bounds[i + 1] = -std::numeric_limits<double>::max();
+    }
+}
+
+bool propBounds(vtkProp* prop, double* bounds)
+{
+    const double* b = prop->GetBounds();
+    if (!b || !vtkMath::AreBoundsInitialized(b))
+        return false;
+    std::copy(b, b + 6, bounds);
+    return true;
+}
+
+// Tests the box against the frustum planes left in 'mask', clearing the planes the box is entirely inside of.
+// The planes of vtkCamera::GetFrustumPlanes() point into the frustum.
+bool outsideFrustum(const double* planes, const double* bounds, int& mask)
+{
+    for (int i = 0; i < 6; ++i) {
+        if (!(mask & (1 << i)))
+            continue;
+        const double* p = planes + 4 * i;
+        double nearest = p[3];
+        double farthest = p[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            const double a = p[axis] * bounds[2 * axis];
+            const double b = p[axis] * bounds[2 * axis + 1];
+            nearest += std::min(a, b);
+            farthest += std::max(a, b);
+        }
+        if (farthest < 0)
+            return true;
+        if (nearest >= 0)
+            mask &= ~(1 << i);
+    }
+    return false;
+}
+}
+
+HierarchicalCuller::~HierarchicalCuller()
+{
+    if (this->Renderer)
+        this->Renderer->RemoveObserver(this->EndObserver);
+}
+
+bool HierarchicalCuller::NeedsRebuild(vtkProp** propList, int listLength) const
+{
+    return listLength != static_cast<int>(this->Props.size()) || !std::equal(propList, propList + listLength, this->Props.begin());
+}
+
+void HierarchicalCuller::Rebuild(vtkProp** propList, int listLength)
+{
+    this->Props.assign(propList, propList + listLength);
+    this->PropBounds.resize(6 * listLength);
+    this->Unbounded.clear();
+    this->Order.clear();
+    this->Nodes.clear();
+    for (int i = 0; i < listLength; ++i) {
+        if (propBounds(propList[i], &this->PropBounds[6 * i]))
+            this->Order.push_back(i);
+        else
+            this->Unbounded.push_back(i);
+    }
+    if (!this->Order.empty())
+        this->BuildNode(0, static_cast<int>(this->Order.size()));
+    this->BuildTime.Modified();
+}
+
+int HierarchicalCuller::BuildNode(int first, int count)
+{
+    const int index = static_cast<int>(this->Nodes.size());
+    this->Nodes.push_back(Node{{}, first, count});
+    double bounds[6];
+    emptyBounds(bounds);
+    for (int i = first; i < first + count; ++i)
+        unite(bounds, &this->PropBounds[6 * this->Order[i]]);
+    std::copy(bounds, bounds + 6, this->Nodes[index].Bounds);
+
+    if (count <= LeafSize)
+        return index;
+
+    // Split at the median of the centers along the longest side
+    int axis = 0;
+    for (int a = 1; a < 3; ++a)
+        if (bounds[2 * a + 1] - bounds[2 * a] > bounds[2 * axis + 1] - bounds[2 * axis])
+            axis = a;
+    const auto center = [this, axis](int prop) {
+        return this->PropBounds[6 * prop + 2 * axis] + this->PropBounds[6 * prop + 2 * axis + 1];
+    };
+    const int half = count / 2;
+    std::nth_element(this->Order.begin() + first, this->Order.begin() + first + half, this->Order.begin() + first + count,
+                     [&center](int a, int b) { return center(a) < center(b); });
+
+    // note: Nodes may reallocate while building the children
+    const int left = this->BuildNode(first, half);
+    const int right = this->BuildNode(first + half, count - half);
+    this->Nodes[index].Left = left;
+    this->Nodes[index].Right = right;
+    return index;
+}
+
+int HierarchicalCuller::Refit(vtkProp** propList, int listLength)
+{
+    // A redraw doesn't always move the prop, eg. the highlight of a picked actor, that keeps the previous depth usable
+    bool redrawn = false;
+    bool changed = false;
+    for (int i = 0; i < listLength; ++i) {
+        if (propList[i]->GetRedrawMTime() <= this->BuildTime)
+            continue;
+        redrawn = true;
+        const bool wasBounded = std::find(this->Unbounded.begin(), this->Unbounded.end(), i) == this->Unbounded.end();
+        double bounds[6];
+        if (propBounds(propList[i], bounds) != wasBounded)
+            return -1;
+        if (!wasBounded || std::equal(bounds, bounds + 6, &this->PropBounds[6 * i]))
+            continue;
+        std::copy(bounds, bounds + 6, &this->PropBounds[6 * i]);
+        changed = true;
+    }
+    if (!changed) {
+        if (redrawn)
+            this->BuildTime.Modified();
+        return 0;
+    }
+
+    // Children always come after their parent
+    for (auto node = this->Nodes.rbegin(); node != this->Nodes.rend(); ++node) {
+        emptyBounds(node->Bounds);
+        if (node->Left < 0) {
+            for (int i = node->First; i < node->First + node->Count; ++i)
+                unite(node->Bounds, &this->PropBounds[6 * this->Order[i]]);
+        } else {
+            unite(node->Bounds, this->Nodes[node->Left].Bounds);
+            unite(node->Bounds, this->Nodes[node->Right].Bounds);
+        }
+    }
+    this->BuildTime.Modified();
+    return 1;
+}
+
+void HierarchicalCuller::PrepareOcclusion(vtkRenderer* renderer)
+{
+    this->OcclusionUsable = false;
+
+    // The depth is read back at the end of every frame of this renderer
+    if (this->OcclusionCulling && this->Renderer != renderer) {
+        if (this->Renderer)
+            this->Renderer->RemoveObserver(this->EndObserver);
+        this->Renderer = renderer;
+        this->EndObserver = renderer->AddObserver(vtkCommand::EndEvent, this, &HierarchicalCuller::CaptureDepth);
+        this->DepthValid = false;
+    }
+    if (!this->OcclusionCulling || !this->DepthValid)
+        return;
+
+    // Only the very same view can reuse the previous depth
+    auto camera = renderer->GetActiveCamera();
+    if (camera->GetMTime() != this->DepthCameraMTime || !std::equal(this->FrameViewport, this->FrameViewport + 4, this->DepthViewport))
+        return;
+
+    vtkMatrix4x4::DeepCopy(this->Projection, camera->GetCompositeProjectionTransformMatrix(renderer->GetTiledAspectRatio(), -1, 1));
+    this->OcclusionUsable = true;
+}
+
+bool HierarchicalCuller::IsOccluded(const double bounds[6]) const
+{
+    const double* m = this->Projection;
+    double minX = std::numeric_limits<double>::max(), maxX = -minX;
+    double minY = minX, maxY = -minX;
+    double nearest = minX;
+    for (int corner = 0; corner < 8; ++corner) {
+        const double p[3] = {bounds[corner & 1], bounds[2 + ((corner >> 1) & 1)], bounds[4 + ((corner >> 2) & 1)]};
+        double clip[4];
+        for (int r = 0; r < 4; ++r)
+            clip[r] = m[4 * r] * p[0] + m[4 * r + 1] * p[1] + m[4 * r + 2] * p[2] + m[4 * r + 3];
+        // Reaches behind the eye, no sensible projection
+        if (clip[3] <= 1e-9)
+            return false;
+        const double sx = (clip[0] / clip[3] * 0.5 + 0.5) * this->DepthViewport[2];
+        const double sy = (clip[1] / clip[3] * 0.5 + 0.5) * this->DepthViewport[3];
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+        nearest = std::min(nearest, clip[2] / clip[3] * 0.5 + 0.5);
+    }
+
+    const int tx0 = std::max(0, static_cast<int>(std::floor(minX / TileSize)));
+    const int tx1 = std::min(this->DepthTilesX - 1, static_cast<int>(std::floor(maxX / TileSize)));
+    const int ty0 = std::max(0, static_cast<int>(std::floor(minY / TileSize)));
+    const int ty1 = std::min(this->DepthTilesY - 1, static_cast<int>(std::floor(maxY / TileSize)));
+    if (tx0 > tx1 || ty0 > ty1)
+        return false;
+
+    // Hidden only if something nearer covers every tile it touches
+    for (int ty = ty0; ty <= ty1; ++ty)
+        for (int tx = tx0; tx <= tx1; ++tx)
+            if (this->DepthTiles[ty * this->DepthTilesX + tx] >= nearest)
+                return false;
+    return true;
+}
+
+void HierarchicalCuller::CaptureDepth()
+{
+    // A frame culled with the previous depth leaves the same depth, it stays valid for as long as nothing changes
+    if (this->OcclusionUsable)
+        return;
+
+    // The depth of a moving view is stale by the next frame, so it is only worth the stall once the view stops
+    this->DepthValid = false;
+    auto window = this->Renderer ? this->Renderer->GetRenderWindow() : nullptr;
+    if (!this->OcclusionCulling || !window || !this->FrameStill)
+        return;
+
+    QQUICKVTK_TRACE_SCOPE("captureDepth");
+    const int x = this->FrameViewport[0];
+    const int y = this->FrameViewport[1];
+    const int width = this->FrameViewport[2];
+    const int height = this->FrameViewport[3];
+    if (width <= 0 || height <= 0)
+        return;
+    window->GetZbufferData(x, y, x + width - 1, y + height - 1, this->Depth);
+    if (this->Depth->GetNumberOfTuples() < static_cast<vtkIdType>(width) * height)
+        return;
+
+    this->DepthTilesX = (width + TileSize - 1) / TileSize;
+    this->DepthTilesY = (height + TileSize - 1) / TileSize;
+    this->DepthTiles.assign(static_cast<size_t>(this->DepthTilesX) * this->DepthTilesY, 0.0f);
+    const float* depth = this->Depth->GetPointer(0);
+    for (int row = 0; row < height; ++row) {
+        float* tiles = &this->DepthTiles[static_cast<size_t>(row / TileSize) * this->DepthTilesX];
+        for (int column = 0; column < width; ++column) {
+            float& tile = tiles[column / TileSize];
+            tile = std::max(tile, depth[static_cast<size_t>(row) * width + column]);
+        }
+    }
+
+    std::copy(this->FrameViewport, this->FrameViewport + 4, this->DepthViewport);
+    this->DepthCameraMTime = this->FrameCameraMTime;
+    this->DepthValid = true;
+}
+
+double HierarchicalCuller::Cull(vtkRenderer* renderer, vtkProp** propList, int& listLength, int& initialized)
+{
+    QQUICKVTK_TRACE_SCOPE("cull", "props", listLength);
+    const auto start = std::chrono::steady_clock::now();
+
+    Statistics statistics;
+    statistics.Props = listLength;
+
+    int refit = -1;
+    if (!this->NeedsRebuild(propList, listLength))
+        refit = this->Refit(propList, listLength);
+    if (refit < 0) {
+        this->Rebuild(propList, listLength);
+        statistics.Rebuilt = true;
+    }
+
+    // The view of this frame, still if neither the camera nor the viewport nor any prop has changed since the last one
+    int viewport[4];
+    renderer->GetTiledSizeAndOrigin(&viewport[2], &viewport[3], &viewport[0], &viewport[1]);
+    const vtkMTimeType cameraMTime = renderer->GetActiveCamera()->GetMTime();
+    this->FrameStill = refit == 0 && cameraMTime == this->FrameCameraMTime
+        && std::equal(viewport, viewport + 4, this->FrameViewport);
+    this->FrameCameraMTime = cameraMTime;
+    std::copy(viewport, viewport + 4, this->FrameViewport);
+
+    // Anything that moved may uncover what the previous depth hides
+    this->PrepareOcclusion(renderer);
+    if (refit != 0)
+        this->OcclusionUsable = false;
+
+    double planes[24];
+    renderer->GetActiveCamera()->GetFrustumPlanes(renderer->GetTiledAspectRatio(), planes);
+
+    this->Keep.assign(listLength, 0);
+    for (int prop : this->Unbounded)
+        this->Keep[prop] = 1;
+
+    struct Entry { int node; int mask; };
+    std::vector<Entry> stack;
+    if (!this->Nodes.empty())
+        stack.push_back({0, AllPlanes});
+    while (!stack.empty()) {
+        auto [index, mask] = stack.back();
+        stack.pop_back();
+        const Node& node = this->Nodes[index];
+
+        if (outsideFrustum(planes, node.Bounds, mask)) {
+            statistics.Culled += node.Count;
+            continue;
+        }
+        if (this->OcclusionUsable && this->IsOccluded(node.Bounds)) {
+            statistics.Occluded += node.Count;
+            continue;
+        }
+        if (node.Left >= 0) {
+            // The planes the node is entirely inside of are not tested again below it
+            stack.push_back({node.Right, mask});
+            stack.push_back({node.Left, mask});
+            continue;
+        }
+
+        for (int i = node.First; i < node.First + node.Count; ++i) {
+            const int prop = this->Order[i];
+            const double* bounds = &this->PropBounds[6 * prop];
+            int propMask = mask;
+            if (propMask && outsideFrustum(planes, bounds, propMask))
+                ++statistics.Culled;
+            else if (this->OcclusionUsable && this->IsOccluded(bounds))
+                ++statistics.Occluded;
+            else
+                this->Keep[prop] = 1;
+        }
+    }
+
+    // Keep the order of the list, and the render time multipliers of any culler before this one
+    double totalTime = 0;
+    int kept = 0;
+    for (int i = 0; i < listLength; ++i) {
+        if (!this->Keep[i])
+            continue;
+        totalTime += initialized ? propList[i]->GetRenderTimeMultiplier() : 1.0;
+        propList[kept++] = propList[i];
+    }
+    listLength = kept;
+
+    statistics.Drawn = kept;
+    statistics.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    this->LastStatistics = statistics;
+    return totalTime;
+}
@@ -0,0 +1,120 @@
+#ifndef HIERARCHICALCULLER_H
+#define HIERARCHICALCULLER_H
+
+#include <vtkCuller.h>
+#include <vtkNew.h>
+#include <vtkTimeStamp.h>
+#include <vtkWeakPointer.h>
+
+#include <vector>
+
+class vtkFloatArray;
+class vtkProp;
+class vtkRenderer;
+
+/**
+* Frustum and occlusion culling for scenes of many props, eg. one vtkActor per object.
+*
+* A bounding volume hierarchy over the props rejects whole subtrees against the view frustum, and subtrees entirely
+* inside the frustum are accepted without testing their props.  The hierarchy is only rebuilt when the props change.
+*
+* With OcclusionCulling on, once the view has stayed the same for a frame (camera, viewport and prop bounds), that
+* frame's depth buffer is read back as a grid of tiles holding their farthest depth.  The following frames of that same
+* view skip the subtrees whose nearest point is behind every tile they cover, until anything moves.  That is
+* conservative: anything that was visible still writes its own depth, so it stays.
+*
+* So occlusion culling only speeds up the redraws of a still view, eg. a picked actor highlighted, a property edited or
+* the full quality frame after interacting.  Moving views, while interacting or animating, are culled by the frustum
+* alone and don't read the depth back.
+*
+*   vtkNew<HierarchicalCuller> culler;
+*   vtkNew<vtkFrustumCoverageCuller> coverageCuller;
+*   renderer->GetCullers()->RemoveAllItems();
+*   renderer->AddCuller(culler);
+*   renderer->AddCuller(coverageCuller);
+*
+* \note This culler doesn't set the render time multipliers of the props, keep the coverage culler after it so that
+*       the frame budget is still shared by screen coverage (PointCloudMapper sizes its subsample from that share).  It then
+*       only tests the props left by this one.
+*
+* \note Reading back the depth stalls the GPU a little, once each time the view stops, so occlusion culling is off by default
+*/
+class HierarchicalCuller : public vtkCuller
+{
+public:
+    static HierarchicalCuller* New();
+    vtkTypeMacro(HierarchicalCuller, vtkCuller);
+
+    vtkSetMacro(OcclusionCulling, bool);
+    vtkGetMacro(OcclusionCulling, bool);
+    vtkBooleanMacro(OcclusionCulling, bool);
+
+    // Of the last Cull(), the props culled as outside the frustum or as occluded are not drawn
+    struct Statistics
+    {
+        int Props = 0;
+        int Culled = 0;
+        int Occluded = 0;
+        int Drawn = 0;
+        bool Rebuilt = false;
+        double Seconds = 0;
+    };
+    const Statistics& GetLastStatistics() const { return this->LastStatistics; }
+
+    double Cull(vtkRenderer* renderer, vtkProp** propList, int& listLength, int& initialized) override;
+
+protected:
+    HierarchicalCuller() = default;
+    ~HierarchicalCuller() override;
+
+private:
+    struct Node
+    {
+        double Bounds[6];
+        int First;          // into Order
+        int Count;
+        int Left = -1;      // leaves have no children
+        int Right = -1;
+    };
+
+    bool NeedsRebuild(vtkProp** propList, int listLength) const;
+    void Rebuild(vtkProp** propList, int listLength);
+    int Refit(vtkProp** propList, int listLength);
+    int BuildNode(int first, int count);
+    void PrepareOcclusion(vtkRenderer* renderer);
+    bool IsOccluded(const double bounds[6]) const;
+    void CaptureDepth();
+
+    bool OcclusionCulling = false;
+    Statistics LastStatistics;
+
+    // The hierarchy, over the props of the list it was built from
+    std::vector<vtkProp*> Props;
+    std::vector<double> PropBounds;     // 6 per prop
+    std::vector<int> Unbounded;         // props without bounds are always drawn
+    std::vector<int> Order;
+    std::vector<Node> Nodes;
+    vtkTimeStamp BuildTime;
+
+    // The depth of the previous frame, see OcclusionCulling
+    vtkWeakPointer<vtkRenderer> Renderer;
+    unsigned long EndObserver = 0;
+    vtkNew<vtkFloatArray> Depth;
+    std::vector<float> DepthTiles;      // farthest depth per tile
+    int DepthTilesX = 0;
+    int DepthTilesY = 0;
+    int DepthViewport[4] = {};          // x, y, width, height in pixels
+    vtkMTimeType DepthCameraMTime = 0;
+    bool DepthValid = false;
+    bool OcclusionUsable = false;       // for the frame being culled
+    bool FrameStill = false;            // the frame being culled has the same view as the one before
+    vtkMTimeType FrameCameraMTime = 0;
+    int FrameViewport[4] = {};
+    double Projection[16] = {};         // world to clip, row major
+    std::vector<char> Keep;
+
+    HierarchicalCuller(const HierarchicalCuller&) = delete;
+    void operator=(const HierarchicalCuller&) = delete;
+};
+
+#endif // HIERARCHICALCULLER_H
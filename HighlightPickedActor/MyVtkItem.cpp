@@ -1,19 +1,46 @@
 
 #include "MyVtkItem.h"
+#include "AdaptiveVolumeQuality.h"
+#include "HierarchicalCuller.h"
+#include "PointCloud.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QThread>
 
 #include <vtkActor.h>
+#include <vtkColorTransferFunction.h>
+#include <vtkCullerCollection.h>
+#include <vtkBitArray.h>
+#include <vtkFloatArray.h>
+#include <vtkFrustumCoverageCuller.h>
+#include <vtkGPUVolumeRayCastMapper.h>
+#include <vtkGlyph3DMapper.h>
+#include <vtkImageData.h>
 #include <vtkInteractorStyleTrackballCamera.h>
 #include <vtkMinimalStandardRandomSequence.h>
 #include <vtkNamedColors.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkPropPicker.h>
+#include <vtkRTAnalyticSource.h>
 #include <vtkProperty.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkRenderer.h>
 #include <vtkSphereSource.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkVolume.h>
+#include <vtkVolumeProperty.h>
+#include <vtkWeakPointer.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 namespace {
 // Handle mouse events
@@ -26,7 +53,6 @@ public:
 
     MouseInteractorHighLightActor()
     {
-        LastPickedActor = NULL;
         LastPickedProperty = vtkProperty::New();
     }
     virtual ~MouseInteractorHighLightActor()
@@ -66,8 +92,10 @@ public:
         vtkInteractorStyleTrackballCamera::OnLeftButtonDown();
     }
 
+    vtkActor* GetLastPickedActor() const { return this->LastPickedActor; }
+
 private:
-    vtkActor* LastPickedActor;
+    vtkWeakPointer<vtkActor> LastPickedActor;   // the spheres can be rebuilt at any time
     vtkProperty* LastPickedProperty;
 };
 
@@ -81,9 +109,285 @@ struct MyVtkData : vtkObject
     vtkTypeMacro(MyVtkData, vtkObject);
 
     // Place all your persistant VTK objects here
+    vtkSmartPointer<vtkRenderer> Renderer;
+    vtkSmartPointer<MouseInteractorHighLightActor> Style;
+    vtkNew<HierarchicalCuller> Culler;
+
+    // The picked sphere as last reported in the snapshots, see MyVtkItem::MyVtkItem()
+    vtkWeakPointer<vtkActor> SnapshotPicked;
+    int SnapshotPickedIndex = -1;
+
+    // The sphere actors, rebuilt whenever MyVtkItem::numberOfSpheres changes
+    std::vector<vtkSmartPointer<vtkActor>> Spheres;
+    int SpheresGeneration = 0;
+
+    // The instanced objects mirrored from the SceneStore, drawn by a single glyph mapper
+    vtkNew<vtkPolyData> Objects;
+    vtkNew<vtkFloatArray> Positions;
+    vtkNew<vtkFloatArray> Scales;
+    vtkNew<vtkUnsignedCharArray> Colors;
+    vtkNew<vtkBitArray> Visibilities;       // the glyph mapper only masks with a bit array
+
+    // The point cloud, see MyVtkItem::pointCloudSize
+    vtkSmartPointer<vtkActor> PointCloudProp;
+    vtkNew<vtkProperty> PointCloudProperty;
+
+    // The volume, see MyVtkItem::volumeResolution
+    vtkSmartPointer<vtkVolume> Volume;
+    vtkNew<AdaptiveVolumeQuality> VolumeQuality;
 };
 
 vtkStandardNewMacro(MyVtkData);
+
+// Opens a gap of 'count' tuples at 'index', or closes one, keeping the tuples before and after it
+template<class Array>
+void shiftTuples(Array* array, SceneStore::Op const& op)
+{
+    const int comps = array->GetNumberOfComponents();
+    const vtkIdType size = array->GetNumberOfTuples();
+    const vtkIdType tail = size - op.index - (op.type == SceneStore::Op::Remove ? op.count : 0);
+    if (op.type == SceneStore::Op::Insert) {
+        array->SetNumberOfTuples(size + op.count);
+        auto data = array->GetPointer(0) + comps * op.index;
+        std::copy_backward(data, data + comps * tail, data + comps * (tail + op.count));
+    } else {
+        auto data = array->GetPointer(0) + comps * op.index;
+        std::copy(data + comps * op.count, data + comps * (op.count + tail), data);
+        array->SetNumberOfTuples(size - op.count);
+    }
+}
+
+// The same for the bits of the mask
+void shiftTuples(vtkBitArray* array, SceneStore::Op const& op)
+{
+    const vtkIdType size = array->GetNumberOfTuples();
+    if (op.type == SceneStore::Op::Insert) {
+        array->SetNumberOfTuples(size + op.count);
+        for (vtkIdType i = size - 1; i >= op.index; --i)
+            array->SetValue(i + op.count, array->GetValue(i));
+    } else {
+        for (vtkIdType i = op.index + op.count; i < size; ++i)
+            array->SetValue(i - op.count, array->GetValue(i));
+        array->SetNumberOfTuples(size - op.count);
+    }
+}
+
+// Copy the changed ranges into the VTK arrays, VTK then re-uploads each modified array once
+void uploadStore(MyVtkData* vtk, SceneStore::Changes const& changes)
+{
+    // Inserted and removed objects shift the arrays in place, only the new objects are in the changed ranges
+    for (auto const& op : changes.ops) {
+        shiftTuples(vtk->Positions.GetPointer(), op);
+        shiftTuples(vtk->Scales.GetPointer(), op);
+        shiftTuples(vtk->Colors.GetPointer(), op);
+        shiftTuples(vtk->Visibilities.GetPointer(), op);
+    }
+    if (changes.countChanged) {
+        // After a markAllDirty() the arrays are new and there is nothing to shift
+        vtk->Positions->SetNumberOfTuples(changes.count);
+        vtk->Scales->SetNumberOfTuples(changes.count);
+        vtk->Colors->SetNumberOfTuples(changes.count);
+        vtk->Visibilities->SetNumberOfTuples(changes.count);
+        vtk->Positions->Modified();
+        vtk->Scales->Modified();
+        vtk->Colors->Modified();
+        vtk->Visibilities->Modified();
+        vtk->Objects->GetPoints()->Modified();
+    }
+
+    auto copy = [](auto* array, auto const& values, std::vector<SceneStore::Range> const& ranges) {
+        const int comps = array->GetNumberOfComponents();
+        auto src = values.begin();
+        for (auto const& r : ranges) {
+            const auto n = comps * (r.end - r.begin);
+            std::copy(src, src + n, array->GetPointer(comps * r.begin));
+            src += n;
+        }
+        if (!ranges.empty())
+            array->Modified();
+    };
+    copy(vtk->Positions.GetPointer(), changes.positions, changes.ranges[SceneStore::Position]);
+    copy(vtk->Scales.GetPointer(), changes.scales, changes.ranges[SceneStore::Scale]);
+    copy(vtk->Colors.GetPointer(), changes.colors, changes.ranges[SceneStore::Color]);
+
+    auto const& ranges = changes.ranges[SceneStore::Visibility];
+    auto src = changes.visibilities.begin();
+    for (auto const& r : ranges)
+        for (int i = r.begin; i < r.end; ++i)
+            vtk->Visibilities->SetValue(i, *src++ ? 1 : 0);
+    if (!ranges.empty())
+        vtk->Visibilities->Modified();
+}
+
+// Replace the point cloud, or just remove it when there are no points
+void replacePointCloud(MyVtkData* vtk, vtkFloatArray* points, vtkUnsignedCharArray* colors)
+{
+    if (vtk->PointCloudProp)
+        vtk->Renderer->RemoveViewProp(vtk->PointCloudProp);
+    vtk->PointCloudProp = nullptr;
+    if (!points)
+        return;
+
+    vtk->PointCloudProp = PointCloud::createProp(points, colors, vtk->PointCloudProperty);
+    // Picking among millions of points would only slow down the highlighting of the spheres
+    vtk->PointCloudProp->PickableOff();
+    vtk->Renderer->AddViewProp(vtk->PointCloudProp);
+}
+
+// Replace the volume, or just remove it when there is no image
+void replaceVolume(MyVtkData* vtk, vtkImageData* image)
+{
+    if (vtk->Volume)
+        vtk->Renderer->RemoveViewProp(vtk->Volume);
+    vtk->Volume = nullptr;
+    vtk->VolumeQuality->Observe(nullptr, nullptr, 1.0);
+    if (!image)
+        return;
+
+    double range[2];
+    image->GetScalarRange(range);
+    auto const at = [&range](double t) { return range[0] + t * (range[1] - range[0]); };
+
+    vtkNew<vtkColorTransferFunction> color;
+    color->AddRGBPoint(at(0.0), 0.0, 0.0, 0.3);
+    color->AddRGBPoint(at(0.5), 0.9, 0.5, 0.1);
+    color->AddRGBPoint(at(1.0), 1.0, 1.0, 0.9);
+    vtkNew<vtkPiecewiseFunction> opacity;
+    opacity->AddPoint(at(0.0), 0.0);
+    opacity->AddPoint(at(0.4), 0.0);
+    opacity->AddPoint(at(1.0), 0.3);
+
+    vtkNew<vtkVolumeProperty> property;
+    property->SetColor(color);
+    property->SetScalarOpacity(opacity);
+    property->SetInterpolationTypeToLinear();
+    property->ShadeOff();
+
+    vtkNew<vtkGPUVolumeRayCastMapper> mapper;
+    mapper->SetInputData(image);
+    mapper->SetBlendModeToComposite();
+
+    vtk->Volume = vtkSmartPointer<vtkVolume>::New();
+    vtk->Volume->SetMapper(mapper);
+    vtk->Volume->SetProperty(property);
+    vtk->Volume->PickableOff();
+    vtk->Renderer->AddViewProp(vtk->Volume);
+
+    // Full quality takes two samples per voxel
+    double spacing[3];
+    image->GetSpacing(spacing);
+    vtk->VolumeQuality->Observe(vtk->Renderer, mapper, 0.5 * std::min({spacing[0], spacing[1], spacing[2]}));
+}
+
+// A construction step creating the spheres a small chunk per call, see QQuickVtkItem::dispatch_incremental()
+std::function<double(vtkRenderWindow*, QQuickVtkItem::vtkUserData)> buildSpheres(int numberOfSpheres, int generation)
+{
+    auto randomSequence = vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+    randomSequence->SetSeed(8775070);
+
+    vtkNew<vtkNamedColors> colors;
+    const vtkColor3d specularColor = colors->GetColor3d("White");
+
+    return [randomSequence, specularColor, numberOfSpheres, generation, i = 0](vtkRenderWindow*, QQuickVtkItem::vtkUserData userData) mutable -> double {
+        auto vtk = MyVtkData::SafeDownCast(userData);
+
+        // Abandon this build if the spheres have been rebuilt since
+        if (!vtk || vtk->SpheresGeneration != generation)
+            return 1.0;
+
+        for (int chunk = 0; chunk < 64 && i < numberOfSpheres; ++chunk, ++i)
+        {
+            vtkNew<vtkSphereSource> source;
+            double x, y, z, radius;
+            // random position and radius
+            x = randomSequence->GetRangeValue(-5.0, 5.0);
+            randomSequence->Next();
+            y = randomSequence->GetRangeValue(-5.0, 5.0);
+            randomSequence->Next();
+            z = randomSequence->GetRangeValue(-5.0, 5.0);
+            randomSequence->Next();
+            radius = randomSequence->GetRangeValue(0.5, 1.0);
+            randomSequence->Next();
+            source->SetRadius(radius);
+            source->SetCenter(x, y, z);
+            source->SetPhiResolution(11);
+            source->SetThetaResolution(21);
+            vtkNew<vtkPolyDataMapper> mapper;
+            mapper->SetInputConnection(source->GetOutputPort());
+            vtkNew<vtkActor> actor;
+            actor->SetMapper(mapper);
+            double r, g, b;
+            r = randomSequence->GetRangeValue(0.4, 1.0);
+            randomSequence->Next();
+            g = randomSequence->GetRangeValue(0.4, 1.0);
+            randomSequence->Next();
+            b = randomSequence->GetRangeValue(0.4, 1.0);
+            randomSequence->Next();
+            actor->GetProperty()->SetDiffuseColor(r, g, b);
+            actor->GetProperty()->SetDiffuse(0.8);
+            actor->GetProperty()->SetSpecular(0.5);
+            actor->GetProperty()->SetSpecularColor(specularColor.GetData());
+            actor->GetProperty()->SetSpecularPower(30.0);
+            vtk->Renderer->AddActor(actor);
+            vtk->Spheres.push_back(actor.GetPointer());
+        }
+
+        return numberOfSpheres > 0 ? double(i) / numberOfSpheres : 1.0;
+    };
+}
+}
+
+MyVtkItem::MyVtkItem(QQuickItem* parent) : QQuickVtkItem(parent)
+{
+    // The objects come either from the model or from the bulk API, so setting or unsetting a model drops them all
+    connect(this, &QQuickVtkItem::modelChanged, this, [this] {
+        const bool fromModel = std::exchange(m_hadModel, model() != nullptr);
+        if (!m_store.count())
+            return;
+        if (!fromModel)
+            qWarning().nospace() << "MyVtkItem.cpp:" << __LINE__ << ", YIKES!! The model replaces the " << m_store.count() << " objects set through the bulk API";
+        m_store.resize(0);
+        scheduleStoreUpload();
+        Q_EMIT objectCountChanged();
+    });
+
+    // Report the culling and the picked sphere to QML
+    setSnapshotFunction([](Snapshot& snapshot, vtkRenderWindow*, vtkUserData userData) {
+        auto vtk = MyVtkData::SafeDownCast(userData);
+        if (!vtk || !vtk->Style)
+            return;
+
+        auto const& culling = vtk->Culler->GetLastStatistics();
+        snapshot.extra.insert(QStringLiteral("propsCulled"), culling.Culled);
+        snapshot.extra.insert(QStringLiteral("propsOccluded"), culling.Occluded);
+        snapshot.extra.insert(QStringLiteral("cullTime"), 1000 * culling.Seconds);
+        snapshot.extra.insert(QStringLiteral("cullRebuilt"), culling.Rebuilt);
+
+        // Only look the sphere up when the pick changes, there may be 100k of them
+        auto picked = vtk->Style->GetLastPickedActor();
+        if (picked != vtk->SnapshotPicked.GetPointer()) {
+            auto it = std::find(vtk->Spheres.begin(), vtk->Spheres.end(), picked);
+            vtk->SnapshotPicked = picked;
+            vtk->SnapshotPickedIndex = picked && it != vtk->Spheres.end() ? int(it - vtk->Spheres.begin()) : -1;
+        }
+        if (!picked)
+            return;
+
+        snapshot.pickedId = vtk->SnapshotPickedIndex;
+        const double* center = picked->GetCenter();
+        snapshot.pickedCenter = QVector3D(float(center[0]), float(center[1]), float(center[2]));
+    });
+}
+
+MyVtkItem::~MyVtkItem()
+{
+    // The builders only touch what they captured, but they must not outlive the application
+    for (auto builder : {m_pointCloudBuilder, m_volumeBuilder}) {
+        if (!builder)
+            continue;
+        builder->requestInterruption();
+        builder->wait();
+    }
 }
 
 QQuickVtkItem::vtkUserData MyVtkItem::initializeVTK(vtkRenderWindow *renderWindow)
@@ -92,7 +396,7 @@ QQuickVtkItem::vtkUserData MyVtkItem::initializeVTK(vtkRenderWindow *renderWindo
 
     vtkNew<vtkNamedColors> colors;
 
-    int numberOfSpheres = 10;
+    int numberOfSpheres = m_numberOfSpheres;
 //remove    if (argc > 1)
 //remove    {
 //remove        numberOfSpheres = atoi(argv[1]);
@@ -116,45 +420,390 @@ QQuickVtkItem::vtkUserData MyVtkItem::initializeVTK(vtkRenderWindow *renderWindo
 //adjust    renderWindowInteractor->SetInteractorStyle(style);
     renderWindow->GetInteractor()->SetInteractorStyle(style);
 
-    vtkNew<vtkMinimalStandardRandomSequence> randomSequence;
-    randomSequence->SetSeed(8775070);
-    for (int i = 0; i < numberOfSpheres; ++i)
-    {
-        vtkNew<vtkSphereSource> source;
-        double x, y, z, radius;
-        // random position and radius
-        x = randomSequence->GetRangeValue(-5.0, 5.0);
-        randomSequence->Next();
-        y = randomSequence->GetRangeValue(-5.0, 5.0);
-        randomSequence->Next();
-        z = randomSequence->GetRangeValue(-5.0, 5.0);
-        randomSequence->Next();
-        radius = randomSequence->GetRangeValue(0.5, 1.0);
-        randomSequence->Next();
-        source->SetRadius(radius);
-        source->SetCenter(x, y, z);
-        source->SetPhiResolution(11);
-        source->SetThetaResolution(21);
-        vtkNew<vtkPolyDataMapper> mapper;
-        mapper->SetInputConnection(source->GetOutputPort());
-        vtkNew<vtkActor> actor;
-        actor->SetMapper(mapper);
-        double r, g, b;
-        r = randomSequence->GetRangeValue(0.4, 1.0);
-        randomSequence->Next();
-        g = randomSequence->GetRangeValue(0.4, 1.0);
-        randomSequence->Next();
-        b = randomSequence->GetRangeValue(0.4, 1.0);
-        randomSequence->Next();
-        actor->GetProperty()->SetDiffuseColor(r, g, b);
-        actor->GetProperty()->SetDiffuse(0.8);
-        actor->GetProperty()->SetSpecular(0.5);
-        actor->GetProperty()->SetSpecularColor(
-            colors->GetColor3d("White").GetData());
-        actor->GetProperty()->SetSpecularPower(30.0);
-        renderer->AddActor(actor);
-    }
+    vtk->Style = style;
+
+    // One actor per sphere, so cull them a subtree at a time rather than one by one
+    vtk->Culler->SetOcclusionCulling(m_occlusionCulling);
+    renderer->GetCullers()->RemoveAllItems();
+    renderer->AddCuller(vtk->Culler);
+    // Then the coverage culler shares the frame budget among the props left, eg. the point cloud's level of detail
+    vtkNew<vtkFrustumCoverageCuller> coverageCuller;
+    renderer->AddCuller(coverageCuller);
+
+    // Build the spheres across frames, so that the first frames show up right away even with 100k of them
+    vtk->Renderer = renderer;
+    // note: This also makes any rebuild still queued from before stale
+    vtk->SpheresGeneration = ++m_spheresGeneration;
+    dispatch_incremental(buildSpheres(numberOfSpheres, vtk->SpheresGeneration));
+
+    // The instanced objects of the SceneStore, all drawn by one glyph mapper
+    vtk->Positions->SetNumberOfComponents(3);
+    vtk->Scales->SetName("scale");
+    vtk->Colors->SetNumberOfComponents(4);
+    vtk->Colors->SetName("color");
+    vtk->Visibilities->SetName("visible");
+    vtkNew<vtkPoints> points;
+    points->SetData(vtk->Positions);
+    vtk->Objects->SetPoints(points);
+    vtk->Objects->GetPointData()->AddArray(vtk->Scales);
+    vtk->Objects->GetPointData()->AddArray(vtk->Colors);
+    vtk->Objects->GetPointData()->AddArray(vtk->Visibilities);
+
+    vtkNew<vtkSphereSource> glyph;
+    glyph->SetRadius(1.0);
+    glyph->SetPhiResolution(11);
+    glyph->SetThetaResolution(21);
+    vtkNew<vtkGlyph3DMapper> glyphMapper;
+    glyphMapper->SetSourceConnection(glyph->GetOutputPort());
+    glyphMapper->SetInputData(vtk->Objects);
+    glyphMapper->SetScaleArray("scale");
+    glyphMapper->SetScaleModeToScaleByMagnitude();
+    glyphMapper->ScalingOn();
+    glyphMapper->SetMaskArray("visible");
+    glyphMapper->MaskingOn();
+    glyphMapper->SetScalarModeToUsePointFieldData();
+    glyphMapper->SelectColorArray("color");
+    glyphMapper->SetColorModeToDirectScalars();
+    glyphMapper->ScalarVisibilityOn();
+    vtkNew<vtkActor> glyphActor;
+    glyphActor->SetMapper(glyphMapper);
+    glyphActor->PickableOff();
+    glyphActor->GetProperty()->SetDiffuse(0.8);
+    glyphActor->GetProperty()->SetSpecular(0.5);
+    glyphActor->GetProperty()->SetSpecularColor(
+        colors->GetColor3d("White").GetData());
+    glyphActor->GetProperty()->SetSpecularPower(30.0);
+    renderer->AddActor(glyphActor);
+
+    // The VTK objects are new, so the whole store has to be uploaded
+    m_store.markAllDirty();
+    uploadStore(vtk, m_store.takeChanges());
+
+    // Screen space sprites, shaded as spheres
+    vtk->PointCloudProperty->SetPointSize(m_pointSize);
+    vtk->PointCloudProperty->RenderPointsAsSpheresOn();
+    replacePointCloud(vtk, m_pointCloudPoints, m_pointCloudColors);
+    replaceVolume(vtk, m_volume);
 
     renderer->SetBackground(colors->GetColor3d("SteelBlue").GetData());
     return vtk;
 }
+
+void MyVtkItem::setNumberOfSpheres(int count)
+{
+    if (count == m_numberOfSpheres)
+        return;
+
+    m_numberOfSpheres = count;
+    const int generation = ++m_spheresGeneration;
+    dispatch_async([generation](vtkRenderWindow*, vtkUserData userData) {
+        if (auto vtk = MyVtkData::SafeDownCast(userData); vtk && generation > vtk->SpheresGeneration) {
+            for (auto const& actor : vtk->Spheres)
+                vtk->Renderer->RemoveActor(actor);
+            vtk->Spheres.clear();
+            vtk->SpheresGeneration = generation;
+        }
+    });
+    dispatch_incremental(buildSpheres(count, generation));
+    Q_EMIT numberOfSpheresChanged();
+}
+
+void MyVtkItem::setObjectCount(int count)
+{
+    if (count == m_store.count() || rejectBulkUpdate())
+        return;
+
+    m_store.resize(count);
+    scheduleStoreUpload();
+    Q_EMIT objectCountChanged();
+}
+
+void MyVtkItem::setPointCloudSize(int count)
+{
+    if (count == m_pointCloudSize)
+        return;
+
+    m_pointCloudSize = count;
+    ++*m_pointCloudGeneration;
+
+    // The previous cloud goes right away, the new one shows up when it is ready
+    m_pointCloudPoints = nullptr;
+    m_pointCloudColors = nullptr;
+    uploadPointCloud();
+    buildPointCloud();
+
+    Q_EMIT pointCloudSizeChanged();
+}
+
+void MyVtkItem::buildPointCloud()
+{
+    // One build at a time, the size set meanwhile is built when the running one is done
+    if (m_pointCloudBuilder || m_pointCloudSize <= 0)
+        return;
+
+    // Generating and sorting tens of millions of points takes seconds, which neither the GUI nor the VTK thread can spare
+    const int count = m_pointCloudSize;
+    const int generation = *m_pointCloudGeneration;
+    auto latest = m_pointCloudGeneration;
+    auto points = vtkSmartPointer<vtkFloatArray>::New();
+    auto colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    m_pointCloudBuilder = QThread::create([points, colors, count, generation, latest] {
+        PointCloud::generate(count, 8775070, points, colors);
+        // The sort is the longest part, skip it if the size has changed again since or the item is going away
+        if (*latest == generation && !QThread::currentThread()->isInterruptionRequested())
+            PointCloud::reorderForLevelOfDetail(points, colors, 8775070);
+    });
+    m_pointCloudBuilder->setObjectName("PointCloudBuilder");
+    connect(m_pointCloudBuilder, &QThread::finished, m_pointCloudBuilder, &QObject::deleteLater);
+    // note: Dropped if the item is gone by then
+    connect(m_pointCloudBuilder, &QThread::finished, this, [this, generation, points, colors] {
+        m_pointCloudBuilder = nullptr;
+        if (generation != *m_pointCloudGeneration) {
+            buildPointCloud();
+            return;
+        }
+        m_pointCloudPoints = points;
+        m_pointCloudColors = colors;
+        uploadPointCloud();
+    });
+    m_pointCloudBuilder->start(QThread::LowPriority);
+}
+
+void MyVtkItem::setPointSize(qreal size)
+{
+    if (qFuzzyCompare(size, m_pointSize))
+        return;
+
+    m_pointSize = size;
+    dispatch_async([size](vtkRenderWindow*, vtkUserData userData) {
+        if (auto vtk = MyVtkData::SafeDownCast(userData))
+            vtk->PointCloudProperty->SetPointSize(size);
+    });
+    Q_EMIT pointSizeChanged();
+}
+
+void MyVtkItem::uploadPointCloud()
+{
+    // note: The arrays are not modified once built, so VTK can share them with the GUI thread
+    dispatch_async([points = m_pointCloudPoints, colors = m_pointCloudColors](vtkRenderWindow*, vtkUserData userData) {
+        if (auto vtk = MyVtkData::SafeDownCast(userData))
+            replacePointCloud(vtk, points, colors);
+    });
+}
+
+void MyVtkItem::setVolumeResolution(int resolution)
+{
+    if (resolution == m_volumeResolution)
+        return;
+
+    m_volumeResolution = resolution;
+    ++m_volumeGeneration;
+
+    // The previous volume goes right away, the new one shows up when it is ready
+    m_volume = nullptr;
+    uploadVolume();
+    buildVolume();
+
+    Q_EMIT volumeResolutionChanged();
+}
+
+void MyVtkItem::buildVolume()
+{
+    // One build at a time, the resolution set meanwhile is built when the running one is done
+    if (m_volumeBuilder || m_volumeResolution <= 0)
+        return;
+
+    const int resolution = m_volumeResolution;
+    const int generation = m_volumeGeneration;
+    auto image = vtkSmartPointer<vtkImageData>::New();
+    m_volumeBuilder = QThread::create([image, resolution] {
+        vtkNew<vtkRTAnalyticSource> source;
+        source->SetWholeExtent(-resolution / 2, resolution - resolution / 2 - 1,
+                               -resolution / 2, resolution - resolution / 2 - 1,
+                               -resolution / 2, resolution - resolution / 2 - 1);
+        source->Update();
+        image->ShallowCopy(source->GetOutput());
+        // The same box as the spheres
+        const double spacing = 10.0 / resolution;
+        image->SetSpacing(spacing, spacing, spacing);
+    });
+    m_volumeBuilder->setObjectName("VolumeBuilder");
+    connect(m_volumeBuilder, &QThread::finished, m_volumeBuilder, &QObject::deleteLater);
+    // note: Dropped if the item is gone by then
+    connect(m_volumeBuilder, &QThread::finished, this, [this, generation, image] {
+        m_volumeBuilder = nullptr;
+        if (generation != m_volumeGeneration) {
+            buildVolume();
+            return;
+        }
+        m_volume = image;
+        uploadVolume();
+    });
+    m_volumeBuilder->start(QThread::LowPriority);
+}
+
+void MyVtkItem::uploadVolume()
+{
+    // note: The image is not modified once built, so VTK can share it with the GUI thread
+    dispatch_async([image = m_volume](vtkRenderWindow*, vtkUserData userData) {
+        if (auto vtk = MyVtkData::SafeDownCast(userData))
+            replaceVolume(vtk, image);
+    });
+}
+
+void MyVtkItem::setOcclusionCulling(bool enabled)
+{
+    if (enabled == m_occlusionCulling)
+        return;
+
+    m_occlusionCulling = enabled;
+    dispatch_async([enabled](vtkRenderWindow*, vtkUserData userData) {
+        if (auto vtk = MyVtkData::SafeDownCast(userData))
+            vtk->Culler->SetOcclusionCulling(enabled);
+    });
+    Q_EMIT occlusionCullingChanged();
+}
+
+int MyVtkItem::propsCulled() const
+{
+    return snapshot().extra.value(QStringLiteral("propsCulled")).toInt();
+}
+
+int MyVtkItem::propsOccluded() const
+{
+    return snapshot().extra.value(QStringLiteral("propsOccluded")).toInt();
+}
+
+qreal MyVtkItem::cullTime() const
+{
+    return snapshot().extra.value(QStringLiteral("cullTime")).toReal();
+}
+
+bool MyVtkItem::cullRebuilt() const
+{
+    return snapshot().extra.value(QStringLiteral("cullRebuilt")).toBool();
+}
+
+void MyVtkItem::setPositions(int first, const QByteArray& xyz)
+{
+    setPositions(first, reinterpret_cast<const float*>(xyz.constData()), xyz.size() / int(3 * sizeof(float)));
+}
+
+void MyVtkItem::setScales(int first, const QByteArray& scales)
+{
+    setScales(first, reinterpret_cast<const float*>(scales.constData()), scales.size() / int(sizeof(float)));
+}
+
+void MyVtkItem::setColors(int first, const QByteArray& rgba)
+{
+    setColors(first, reinterpret_cast<const std::uint8_t*>(rgba.constData()), rgba.size() / 4);
+}
+
+void MyVtkItem::setVisibilities(int first, const QByteArray& visible)
+{
+    setVisibilities(first, reinterpret_cast<const std::uint8_t*>(visible.constData()), visible.size());
+}
+
+bool MyVtkItem::rejectBulkUpdate() const
+{
+    if (!model())
+        return false;
+    qWarning().nospace() << "MyVtkItem.cpp:" << __LINE__ << ", YIKES!! The objects come from the model, the bulk update is ignored";
+    return true;
+}
+
+void MyVtkItem::setPositions(int first, const float* xyz, int count)
+{
+    if (rejectBulkUpdate())
+        return;
+    m_store.setPositions(first, xyz, count);
+    scheduleStoreUpload();
+}
+
+void MyVtkItem::setScales(int first, const float* scales, int count)
+{
+    if (rejectBulkUpdate())
+        return;
+    m_store.setScales(first, scales, count);
+    scheduleStoreUpload();
+}
+
+void MyVtkItem::setColors(int first, const std::uint8_t* rgba, int count)
+{
+    if (rejectBulkUpdate())
+        return;
+    m_store.setColors(first, rgba, count);
+    scheduleStoreUpload();
+}
+
+void MyVtkItem::setVisibilities(int first, const std::uint8_t* visible, int count)
+{
+    if (rejectBulkUpdate())
+        return;
+    m_store.setVisibilities(first, visible, count);
+    scheduleStoreUpload();
+}
+
+void MyVtkItem::modelUpdated(const ModelUpdate& update)
+{
+    // The rows of a model that was unset are already gone, see MyVtkItem::MyVtkItem()
+    if (!model())
+        return;
+
+    const int oldCount = m_store.count();
+
+    if (update.reset)
+        m_store.resize(0);
+    for (auto const& op : update.ops) {
+        if (op.type == ModelUpdate::Op::Insert)
+            m_store.insert(op.first, op.count);
+        else
+            m_store.remove(op.first, op.count);
+    }
+    m_store.resize(update.rowCount);
+
+    for (auto const& c : update.changed) {
+        if (c.roles & ModelUpdate::PositionRole) {
+            std::vector<float> xyz;
+            xyz.reserve(3 * c.count);
+            for (auto const& p : c.positions)
+                xyz.insert(xyz.end(), {p.x(), p.y(), p.z()});
+            m_store.setPositions(c.first, xyz.data(), c.count);
+        }
+        if (c.roles & ModelUpdate::ColorRole) {
+            std::vector<std::uint8_t> rgba;
+            rgba.reserve(4 * c.count);
+            for (auto const& color : c.colors)
+                rgba.insert(rgba.end(), {std::uint8_t(color.red()), std::uint8_t(color.green()), std::uint8_t(color.blue()), std::uint8_t(color.alpha())});
+            m_store.setColors(c.first, rgba.data(), c.count);
+        }
+        if (c.roles & ModelUpdate::VisibleRole) {
+            std::vector<std::uint8_t> visible(c.visible.cbegin(), c.visible.cend());
+            m_store.setVisibilities(c.first, visible.data(), c.count);
+        }
+    }
+
+    // No need to schedule anything, this is called from updatePolish() which uploads the store next
+    if (m_store.count() != oldCount)
+        Q_EMIT objectCountChanged();
+}
+
+void MyVtkItem::updatePolish()
+{
+    QQuickVtkItem::updatePolish();
+
+    if (!m_store.isDirty())
+        return;
+
+    // Everything that changed this frame goes to VTK in one go
+    dispatch_async([changes = m_store.takeChanges()](vtkRenderWindow*, vtkUserData userData) {
+        if (auto vtk = MyVtkData::SafeDownCast(userData))
+            uploadStore(vtk, changes);
+    });
+}
+
+void MyVtkItem::scheduleStoreUpload()
+{
+    // Coalesce all the updates of this frame into one upload in updatePolish()
+    polish();
+}
@@ -2,11 +2,140 @@
 #define MYVTKITEM_H
 
 #include "QQuickVtkItem.h"
+#include "SceneStore.h"
+
+#include <QtCore/QByteArray>
+
+#include <atomic>
+#include <memory>
+
+class QThread;
+
+class vtkFloatArray;
+class vtkImageData;
+class vtkUnsignedCharArray;
 
 class MyVtkItem : public QQuickVtkItem
 {
+    Q_OBJECT
+
+    Q_PROPERTY(int numberOfSpheres READ numberOfSpheres WRITE setNumberOfSpheres NOTIFY numberOfSpheresChanged)
+    Q_PROPERTY(int objectCount READ objectCount WRITE setObjectCount NOTIFY objectCountChanged)
+    Q_PROPERTY(int pointCloudSize READ pointCloudSize WRITE setPointCloudSize NOTIFY pointCloudSizeChanged)
+    Q_PROPERTY(qreal pointSize READ pointSize WRITE setPointSize NOTIFY pointSizeChanged)
+    Q_PROPERTY(int volumeResolution READ volumeResolution WRITE setVolumeResolution NOTIFY volumeResolutionChanged)
+    Q_PROPERTY(bool occlusionCulling READ occlusionCulling WRITE setOcclusionCulling NOTIFY occlusionCullingChanged)
+    Q_PROPERTY(int propsCulled READ propsCulled NOTIFY snapshotChanged)
+    Q_PROPERTY(int propsOccluded READ propsOccluded NOTIFY snapshotChanged)
+    Q_PROPERTY(qreal cullTime READ cullTime NOTIFY snapshotChanged)
+    Q_PROPERTY(bool cullRebuilt READ cullRebuilt NOTIFY snapshotChanged)
+
 public:
+    explicit MyVtkItem(QQuickItem* parent = nullptr);
+    ~MyVtkItem() override;
+
     vtkUserData initializeVTK(vtkRenderWindow *renderWindow) override;
+
+    int numberOfSpheres() const { return m_numberOfSpheres; }
+    void setNumberOfSpheres(int count);
+
+    int objectCount() const { return m_store.count(); }
+    void setObjectCount(int count);
+
+    /**
+    * The number of points of a synthetic LiDAR-like scan shown with the spheres, 0 (the default) for none
+    *
+    * \note The cloud is generated and reordered for level of detail on a worker thread, it shows up when ready.
+    *       Only one cloud is built at a time, the sizes set meanwhile are skipped but for the last one.
+    *       While interacting VTK draws a subsample that fits the interactor's DesiredUpdateRate, the full cloud when still.
+    */
+    int pointCloudSize() const { return m_pointCloudSize; }
+    void setPointCloudSize(int count);
+
+    // The size of the points of the cloud, in pixels
+    qreal pointSize() const { return m_pointSize; }
+    void setPointSize(qreal size);
+
+    /**
+    * The number of voxels along each side of a synthetic volume, ray cast around the spheres, 0 (the default) for none
+    *
+    * \note The volume is built on a worker thread, one at a time, and shows up when ready
+    *
+    * \note While interacting the sample distances adapt to the frame budget of the interactor's DesiredUpdateRate,
+    *       see AdaptiveVolumeQuality, the still frames are full quality
+    */
+    int volumeResolution() const { return m_volumeResolution; }
+    void setVolumeResolution(int resolution);
+
+    // Also skip the spheres hidden behind others in the redraws of a still view, see HierarchicalCuller.  It does
+    // nothing for a moving view, while interacting or animating.
+    bool occlusionCulling() const { return m_occlusionCulling; }
+    void setOcclusionCulling(bool enabled);
+
+    // The HierarchicalCuller statistics of the latest frame, from the snapshots
+    int propsCulled() const;
+    int propsOccluded() const;
+    qreal cullTime() const;                                     // milliseconds
+    bool cullRebuilt() const;                                   // the culling structures were rebuilt for the frame
+
+    /**
+    * Bulk updates of the instanced objects, callable from QML with the buffer of a typed array, eg.
+    *   item.setPositions(0, positions.buffer)   // Float32Array, x,y,z per object
+    *   item.setScales(0, scales.buffer)         // Float32Array, one radius per object
+    *   item.setColors(0, colors.buffer)         // Uint8Array, r,g,b,a per object
+    *   item.setVisibilities(0, visible.buffer)  // Uint8Array, 0 hides the object
+    *
+    * \note All updates made during one frame are uploaded to VTK together, copying only the changed ranges
+    *
+    * \note The objects come either from these or from a model, never from both.  While a model is set they (and
+    *       objectCount) are ignored with a warning, and setting or unsetting a model drops all the objects.
+    */
+    Q_INVOKABLE void setPositions(int first, const QByteArray& xyz);
+    Q_INVOKABLE void setScales(int first, const QByteArray& scales);
+    Q_INVOKABLE void setColors(int first, const QByteArray& rgba);
+    Q_INVOKABLE void setVisibilities(int first, const QByteArray& visible);
+
+    // The same for C++ callers, 'count' is the number of objects
+    void setPositions(int first, const float* xyz, int count);
+    void setScales(int first, const float* scales, int count);
+    void setColors(int first, const std::uint8_t* rgba, int count);
+    void setVisibilities(int first, const std::uint8_t* visible, int count);
+
+Q_SIGNALS:
+    void numberOfSpheresChanged();
+    void objectCountChanged();
+    void pointCloudSizeChanged();
+    void pointSizeChanged();
+    void volumeResolutionChanged();
+    void occlusionCullingChanged();
+
+protected:
+    void modelUpdated(const ModelUpdate& update) override;
+    void updatePolish() override;
+
+private:
+    void scheduleStoreUpload();
+    bool rejectBulkUpdate() const;
+    void buildPointCloud();
+    void uploadPointCloud();
+    void buildVolume();
+    void uploadVolume();
+
+    int m_numberOfSpheres = 10;
+    int m_spheresGeneration = 0;
+    SceneStore m_store;
+    bool m_hadModel = false;                                    // as of the last modelChanged()
+    int m_pointCloudSize = 0;
+    std::shared_ptr<std::atomic<int>> m_pointCloudGeneration = std::make_shared<std::atomic<int>>(0);    // also read by the builder
+    QThread* m_pointCloudBuilder = nullptr;                     // at most one build runs
+    qreal m_pointSize = 2.0;
+    vtkSmartPointer<vtkFloatArray> m_pointCloudPoints;          // kept for a re-initialization of VTK
+    vtkSmartPointer<vtkUnsignedCharArray> m_pointCloudColors;
+    int m_volumeResolution = 0;
+    int m_volumeGeneration = 0;
+    QThread* m_volumeBuilder = nullptr;                         // at most one build runs
+    vtkSmartPointer<vtkImageData> m_volume;                     // kept for a re-initialization of VTK
+    bool m_occlusionCulling = false;
 };
 
 #endif // MYVTKITEM_H
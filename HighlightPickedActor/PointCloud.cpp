@@ -0,0 +1,257 @@
+#include "PointCloud.h"
+
+#include <vtkActor.h>
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkOpenGLIndexBufferObject.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkTypeInt32Array.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace PointCloud {
+
+namespace {
+
+// splitmix64, fast enough to generate tens of millions of points and the same on every platform
+struct Random
+{
+    std::uint64_t state;
+
+    std::uint64_t next()
+    {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // [0, 1)
+    float uniform() { return static_cast<float>(next() >> 40) * (1.0f / 16777216.0f); }
+    float uniform(float a, float b) { return a + (b - a) * uniform(); }
+    std::uint64_t below(std::uint64_t n) { return next() % n; }
+};
+
+float terrainHeight(float x, float z)
+{
+    return -6.0f + 0.8f * std::sin(0.7f * x) * std::cos(0.5f * z) + 0.3f * std::sin(1.9f * x + 0.6f * z);
+}
+
+void heightColor(float t, unsigned char* rgb)
+{
+    // green, brown, white from low to high
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    float const low[3] = {60, 140, 50}, mid[3] = {140, 100, 60}, high[3] = {240, 240, 235};
+    auto const a = t < 0.5f ? low : mid;
+    auto const b = t < 0.5f ? mid : high;
+    float const f = t < 0.5f ? 2 * t : 2 * t - 1;
+    for (int i = 0; i < 3; ++i)
+        rgb[i] = static_cast<unsigned char>(a[i] + f * (b[i] - a[i]));
+}
+
+// Interleaves the low 10 bits of x, y and z, so sorting by the code sorts by octree cell at every depth
+std::uint32_t mortonCode(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+    auto spread = [](std::uint32_t v) {
+        v &= 0x3ff;
+        v = (v | (v << 16)) & 0x030000ff;
+        v = (v | (v << 8)) & 0x0300f00f;
+        v = (v | (v << 4)) & 0x030c30c3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    };
+    return (spread(x) << 2) | (spread(y) << 1) | spread(z);
+}
+
+constexpr int OctreeDepth = 10;
+
+} // namespace
+
+void generate(vtkIdType count, std::uint64_t seed, vtkFloatArray* points, vtkUnsignedCharArray* colors)
+{
+    points->SetNumberOfComponents(3);
+    points->SetNumberOfTuples(count);
+    colors->SetName("color");
+    colors->SetNumberOfComponents(3);
+    colors->SetNumberOfTuples(count);
+
+    Random random{seed};
+
+    struct Pole { float x, z, height, radius; };
+    std::vector<Pole> poles(200);
+    for (auto& pole : poles)
+        pole = Pole{random.uniform(-10, 10), random.uniform(-10, 10), random.uniform(1, 4), random.uniform(0.05f, 0.6f)};
+
+    auto p = points->GetPointer(0);
+    auto c = colors->GetPointer(0);
+    for (vtkIdType i = 0; i < count; ++i, p += 3, c += 3) {
+        // Most returns are from the ground, the rest from poles (thin) and trees (wide)
+        if (random.below(10) != 0) {
+            float const x = random.uniform(-10, 10);
+            float const z = random.uniform(-10, 10);
+            p[0] = x;
+            p[1] = terrainHeight(x, z) + random.uniform(-0.02f, 0.02f);
+            p[2] = z;
+            heightColor((p[1] + 7.1f) / 6.0f, c);
+        } else {
+            auto const& pole = poles[random.below(poles.size())];
+            float const h = pole.height * random.uniform();
+            float const r = pole.radius * std::sqrt(random.uniform()) * (pole.radius > 0.3f ? h / pole.height : 1.0f);
+            float const a = random.uniform(0, 6.2831853f);
+            p[0] = pole.x + r * std::cos(a);
+            p[1] = terrainHeight(pole.x, pole.z) + h;
+            p[2] = pole.z + r * std::sin(a);
+            heightColor((p[1] + 7.1f) / 6.0f, c);
+        }
+    }
+    points->Modified();
+    colors->Modified();
+}
+
+void reorderForLevelOfDetail(vtkFloatArray* points, vtkUnsignedCharArray* colors, std::uint64_t seed)
+{
+    auto const count = points->GetNumberOfTuples();
+    if (count < 2)
+        return;
+
+    double bounds[6];
+    points->GetRange(bounds + 0, 0);
+    points->GetRange(bounds + 2, 1);
+    points->GetRange(bounds + 4, 2);
+    double const extent = std::max({bounds[1] - bounds[0], bounds[3] - bounds[2], bounds[5] - bounds[4], 1e-12});
+    double const scale = ((1 << OctreeDepth) - 1) / extent;
+
+    auto const p = points->GetPointer(0);
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> sorted(count);
+    for (vtkIdType i = 0; i < count; ++i) {
+        auto cell = [&](int axis) { return static_cast<std::uint32_t>((p[3 * i + axis] - bounds[2 * axis]) * scale); };
+        sorted[i] = {mortonCode(cell(0), cell(1), cell(2)), static_cast<std::uint32_t>(i)};
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    // A point represents its octree cell from the first depth at which it is not in the cell of the point before it.
+    // Taking the representatives depth by depth gives one point per occupied cell at each depth, a uniform subsample.
+    std::vector<std::uint8_t> level(count);
+    std::vector<vtkIdType> levelSize(OctreeDepth + 2, 0);
+    for (vtkIdType i = 0; i < count; ++i) {
+        int l = 0;
+        if (i > 0) {
+            auto const different = sorted[i].first ^ sorted[i - 1].first;
+            l = OctreeDepth + 1;
+            for (int depth = 1; depth <= OctreeDepth; ++depth)
+                if (different >> (3 * (OctreeDepth - depth))) {
+                    l = depth;
+                    break;
+                }
+        }
+        level[i] = static_cast<std::uint8_t>(l);
+        ++levelSize[l];
+    }
+
+    std::vector<vtkIdType> levelStart(OctreeDepth + 2, 0);
+    for (int l = 1; l < OctreeDepth + 2; ++l)
+        levelStart[l] = levelStart[l - 1] + levelSize[l - 1];
+
+    std::vector<std::uint32_t> order(count);
+    {
+        auto next = levelStart;
+        for (vtkIdType i = 0; i < count; ++i)
+            order[next[level[i]]++] = sorted[i].second;
+    }
+    sorted = {};
+    level = {};
+
+    // Within a level the points are still in spatial order, shuffle them so any prefix is uniform as well
+    Random random{seed};
+    for (int l = 0; l < OctreeDepth + 2; ++l) {
+        auto const first = order.begin() + levelStart[l];
+        for (vtkIdType i = levelSize[l] - 1; i > 0; --i)
+            std::swap(first[i], first[random.below(i + 1)]);
+    }
+
+    auto permute = [&order, count](auto* data, int components) {
+        using T = std::remove_pointer_t<decltype(data)>;
+        std::vector<T> copy(data, data + count * components);
+        for (vtkIdType i = 0; i < count; ++i)
+            std::copy_n(copy.data() + order[i] * std::size_t(components), components, data + i * components);
+    };
+    permute(points->GetPointer(0), 3);
+    points->Modified();
+    if (colors && colors->GetNumberOfTuples() == count) {
+        permute(colors->GetPointer(0), colors->GetNumberOfComponents());
+        colors->Modified();
+    }
+}
+
+vtkSmartPointer<vtkActor> createProp(vtkFloatArray* points, vtkUnsignedCharArray* colors, vtkProperty* property,
+                                     vtkIdType minLevelPoints)
+{
+    vtkNew<vtkPoints> pointSet;
+    pointSet->SetData(points);
+    vtkNew<vtkPolyData> polyData;
+    polyData->SetPoints(pointSet);
+    if (colors)
+        polyData->GetPointData()->SetScalars(colors);
+
+    // One poly vertex of all the points in order, so that a prefix of the index buffer is a prefix of the cloud.
+    // note: 32 bit ids to halve their memory, the size of the cloud is an int anyway
+    auto const count = static_cast<std::int32_t>(points->GetNumberOfTuples());
+    vtkNew<vtkTypeInt32Array> offsets;
+    offsets->SetNumberOfValues(2);
+    offsets->SetValue(0, 0);
+    offsets->SetValue(1, count);
+    vtkNew<vtkTypeInt32Array> connectivity;
+    connectivity->SetNumberOfValues(count);
+    std::iota(connectivity->GetPointer(0), connectivity->GetPointer(0) + count, 0);
+    vtkNew<vtkCellArray> verts;
+    verts->SetData(offsets, connectivity);
+    polyData->SetVerts(verts);
+
+    // Screen space points of the property's point size
+    vtkNew<PointCloudMapper> mapper;
+    mapper->SetInputData(polyData);
+    mapper->SetMinimumPoints(minLevelPoints);
+    mapper->SetScalarModeToUsePointData();
+    mapper->SetColorModeToDirectScalars();
+    mapper->SetScalarVisibility(colors != nullptr);
+
+    auto actor = vtkSmartPointer<vtkActor>::New();
+    actor->SetMapper(mapper);
+    actor->SetProperty(property);
+    return actor;
+}
+
+} // namespace PointCloud
+
+vtkStandardNewMacro(PointCloudMapper);
+
+void PointCloudMapper::RenderPieceDraw(vtkRenderer* renderer, vtkActor* actor)
+{
+    auto const ibo = this->Primitives[PrimitivePoints].IBO;
+    auto const count = static_cast<vtkIdType>(ibo->IndexCount);
+
+    // TimeToDraw is the GPU time of an earlier draw, close enough to the last one to scale by its number of points
+    if (this->DrawnPoints > 0 && this->TimeToDraw > 0)
+        this->SecondsPerPoint = this->TimeToDraw / this->DrawnPoints;
+
+    // The whole cloud when still, the renderer then allocates (far) more time than any draw takes
+    vtkIdType drawn = count;
+    double const budget = actor->GetAllocatedRenderTime();
+    if (this->SecondsPerPoint > 0 && budget > 0 && budget / this->SecondsPerPoint < count)
+        drawn = std::max(static_cast<vtkIdType>(budget / this->SecondsPerPoint), std::min(this->MinimumPoints, count));
+    this->DrawnPoints = drawn;
+
+    ibo->IndexCount = static_cast<std::size_t>(drawn);
+    this->Superclass::RenderPieceDraw(renderer, actor);
+    ibo->IndexCount = static_cast<std::size_t>(count);
+}
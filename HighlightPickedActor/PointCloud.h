@@ -0,0 +1,81 @@
+#ifndef POINTCLOUD_H
+#define POINTCLOUD_H
+
+#include <vtkOpenGLPolyDataMapper.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include <cstdint>
+
+class vtkActor;
+class vtkFloatArray;
+class vtkProperty;
+class vtkUnsignedCharArray;
+
+/**
+* Rendering of large point clouds (tens of millions of points) with one splat mapper, instead of one actor per object.
+*
+* The points are reordered so that every prefix of the arrays is a uniform subsample of the whole cloud (octree level
+* order).  The levels of detail are then just shorter draws of the same buffer, and PointCloudMapper draws the longest
+* prefix that fits the frame budget: the full cloud when still, a subsample while interacting.
+*
+* \note Nothing but the mapper touches OpenGL, so a cloud can be prepared on any thread and handed over to the VTK thread.
+*/
+namespace PointCloud {
+
+// A synthetic LiDAR-like scan: terrain with some poles and trees, colored by height
+void generate(vtkIdType count, std::uint64_t seed, vtkFloatArray* points, vtkUnsignedCharArray* colors);
+
+// Reorders the points (and their rgb colors) in octree level order, randomized within each level
+void reorderForLevelOfDetail(vtkFloatArray* points, vtkUnsignedCharArray* colors, std::uint64_t seed);
+
+/**
+* The prop for a reordered cloud, drawing all the points when still and down to 'minLevelPoints' while interacting
+*
+* \param property, its point size is the size of the splats in pixels
+*
+* \note The prop shares the memory of 'points' and 'colors', keep them unchanged while it is in use
+*/
+vtkSmartPointer<vtkActor> createProp(vtkFloatArray* points, vtkUnsignedCharArray* colors, vtkProperty* property,
+                                     vtkIdType minLevelPoints = 250000);
+
+} // namespace PointCloud
+
+/**
+* Draws the first points of a reordered cloud, as many as fit the render time the renderer gives to the actor
+*
+* The points are uploaded once, as one buffer, and only the number of indices drawn changes from frame to frame.  The
+* time per point comes from the GL timer query of vtkOpenGLPolyDataMapper, read back a frame late, so it never waits
+* for the GPU.
+*
+* \note Expects one poly vertex of all the points in order, see PointCloud::createProp()
+*/
+class PointCloudMapper : public vtkOpenGLPolyDataMapper
+{
+public:
+    static PointCloudMapper* New();
+    vtkTypeMacro(PointCloudMapper, vtkOpenGLPolyDataMapper);
+
+    // The fewest points drawn while interacting, however slow they are
+    vtkSetMacro(MinimumPoints, vtkIdType);
+    vtkGetMacro(MinimumPoints, vtkIdType);
+
+    // The number of points of the last draw
+    vtkGetMacro(DrawnPoints, vtkIdType);
+
+protected:
+    PointCloudMapper() = default;
+    ~PointCloudMapper() override = default;
+
+    void RenderPieceDraw(vtkRenderer* renderer, vtkActor* actor) override;
+
+private:
+    PointCloudMapper(const PointCloudMapper&) = delete;
+    void operator=(const PointCloudMapper&) = delete;
+
+    vtkIdType MinimumPoints = 250000;
+    vtkIdType DrawnPoints = 0;
+    double SecondsPerPoint = 0;
+};
+
+#endif // POINTCLOUD_H
@@ -0,0 +1,100 @@
+// Offscreen throughput of the point cloud rendering, in points per second, for a few cloud sizes
+//
+// usage: PointCloudBenchmark [frames] [points ...]
+//
+// note: To measure the software rasterizer, as on a headless CI machine, run it with
+//         LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe ./PointCloudBenchmark
+//       without an X display VTK has to be built with EGL or OSMesa (or run it under xvfb-run).
+
+#include "PointCloud.h"
+
+#include <vtkActor.h>
+#include <vtkCamera.h>
+#include <vtkFloatArray.h>
+#include <vtkNew.h>
+#include <vtkProperty.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderer.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+}
+
+int main(int argc, char* argv[])
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 20;
+    std::vector<vtkIdType> sizes;
+    for (int i = 2; i < argc; ++i)
+        sizes.push_back(std::atoll(argv[i]));
+    if (sizes.empty())
+        sizes = {1000000, 4000000, 16000000};
+
+    vtkNew<vtkRenderWindow> renderWindow;
+    renderWindow->SetOffScreenRendering(true);
+    renderWindow->SetSize(1280, 720);
+    vtkNew<vtkRenderer> renderer;
+    renderWindow->AddRenderer(renderer);
+    vtkNew<vtkProperty> property;
+    property->SetPointSize(2.0);
+    property->RenderPointsAsSpheresOn();
+
+    std::printf("%12s %10s %10s %12s %12s %14s\n", "points", "build ms", "first ms", "frame ms", "lod frame ms", "Mpoints/s");
+
+    for (auto size : sizes) {
+        auto start = std::chrono::steady_clock::now();
+        vtkNew<vtkFloatArray> points;
+        vtkNew<vtkUnsignedCharArray> colors;
+        PointCloud::generate(size, 8775070, points, colors);
+        PointCloud::reorderForLevelOfDetail(points, colors, 8775070);
+        auto prop = PointCloud::createProp(points, colors, property);
+        double const build = secondsSince(start);
+
+        renderer->RemoveAllViewProps();
+        renderer->AddViewProp(prop);
+        renderer->ResetCamera();
+
+        // The first frame includes the upload to the GPU
+        start = std::chrono::steady_clock::now();
+        renderWindow->Render();
+        renderWindow->WaitForCompletion();
+        double const first = secondsSince(start);
+
+        // Still frames draw every point
+        renderWindow->SetDesiredUpdateRate(0.0001);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            renderer->GetActiveCamera()->Azimuth(2.0);
+            renderWindow->Render();
+        }
+        renderWindow->WaitForCompletion();
+        double const frame = secondsSince(start) / frames;
+
+        // Interactive frames at 30 fps let the mapper draw a subsample once it has timed a draw
+        renderWindow->SetDesiredUpdateRate(30.0);
+        for (int i = 0; i < 3; ++i)
+            renderWindow->Render();
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            renderer->GetActiveCamera()->Azimuth(2.0);
+            renderWindow->Render();
+        }
+        renderWindow->WaitForCompletion();
+        double const lodFrame = secondsSince(start) / frames;
+        renderWindow->SetDesiredUpdateRate(0.0001);
+
+        std::printf("%12lld %10.1f %10.1f %12.2f %12.2f %14.1f\n", static_cast<long long>(size), 1000 * build,
+                    1000 * first, 1000 * frame, 1000 * lodFrame, size / frame / 1e6);
+        std::fflush(stdout);
+    }
+
+    return 0;
+}
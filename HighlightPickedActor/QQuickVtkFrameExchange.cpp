@@ -0,0 +1,114 @@
+#include "QQuickVtkFrameExchange.h"
+
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLExtraFunctions>
+
+#include <utility>
+
+namespace {
+GLsync toSync(void* s) { return static_cast<GLsync>(s); }
+}
+
+void QQuickVtkFrameExchange::publish(GLuint framebuffer, const QSize& size)
+{
+    auto gl = QOpenGLContext::currentContext()->extraFunctions();
+
+    // Write into the slot that is neither composited nor published, dropping an unseen published frame is fine
+    int index = 0;
+    void* released = nullptr;
+    {
+        QMutexLocker lock(&m_mutex);
+        while (index == m_displayed || index == m_published)
+            ++index;
+        released = std::exchange(m_slots[index].released, nullptr);
+    }
+    auto& slot = m_slots[index];
+
+    // Don't overwrite the texture while QML may still be sampling it
+    if (released) {
+        gl->glWaitSync(toSync(released), 0, GL_TIMEOUT_IGNORED);
+        gl->glDeleteSync(toSync(released));
+    }
+
+    if (slot.size != size) {
+        if (!slot.texture)
+            gl->glGenTextures(1, &slot.texture);
+        gl->glBindTexture(GL_TEXTURE_2D, slot.texture);
+        gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.width(), size.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        gl->glBindTexture(GL_TEXTURE_2D, 0);
+        if (!slot.fbo)
+            gl->glGenFramebuffers(1, &slot.fbo);
+        gl->glBindFramebuffer(GL_FRAMEBUFFER, slot.fbo);
+        gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, slot.texture, 0);
+        slot.size = size;
+    }
+
+    // note: VTK re-reads the OpenGL state at the start of every frame, so there is nothing to restore here
+    gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, slot.fbo);
+    gl->glBlitFramebuffer(0, 0, size.width(), size.height(), 0, 0, size.width(), size.height(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLsync ready = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    gl->glFlush();
+
+    QMutexLocker lock(&m_mutex);
+    if (m_published >= 0 && m_slots[m_published].ready)
+        gl->glDeleteSync(toSync(std::exchange(m_slots[m_published].ready, nullptr)));
+    slot.ready = ready;
+    m_published = index;
+}
+
+void QQuickVtkFrameExchange::release()
+{
+    auto gl = QOpenGLContext::currentContext()->extraFunctions();
+
+    QMutexLocker lock(&m_mutex);
+    for (auto& slot : m_slots) {
+        if (slot.ready)
+            gl->glDeleteSync(toSync(slot.ready));
+        if (slot.released)
+            gl->glDeleteSync(toSync(slot.released));
+        if (slot.fbo)
+            gl->glDeleteFramebuffers(1, &slot.fbo);
+        if (slot.texture)
+            gl->glDeleteTextures(1, &slot.texture);
+        slot = Slot();
+    }
+    m_published = m_displayed = -1;
+}
+
+bool QQuickVtkFrameExchange::acquire(Frame& frame)
+{
+    auto gl = QOpenGLContext::currentContext()->extraFunctions();
+
+    QMutexLocker lock(&m_mutex);
+    if (m_published < 0)
+        return false;
+
+    // The commands issued so far may still sample the previously composited texture, fence them
+    if (m_displayed >= 0) {
+        auto& previous = m_slots[m_displayed];
+        if (previous.released)
+            gl->glDeleteSync(toSync(previous.released));
+        previous.released = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        gl->glFlush();
+    }
+
+    m_displayed = std::exchange(m_published, -1);
+    auto& slot = m_slots[m_displayed];
+    if (slot.ready) {
+        // Waits on the GPU, not here
+        gl->glWaitSync(toSync(slot.ready), 0, GL_TIMEOUT_IGNORED);
+        gl->glDeleteSync(toSync(slot.ready));
+        slot.ready = nullptr;
+    }
+
+    frame.slot = m_displayed;
+    frame.texture = slot.texture;
+    frame.size = slot.size;
+    return true;
+}
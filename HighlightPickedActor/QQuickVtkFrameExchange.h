@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QtGui/qopengl.h>
+
+#include <QtCore/QMutex>
+#include <QtCore/QSize>
+
+/**
+* Hands finished VTK frames from the VTK render thread over to the QML render thread without either one waiting.
+*
+* There are three textures, shared between the two OpenGL contexts: one being composited by QML, one published
+* (the latest finished frame) and one being written.  A fence guards each hand-over in both directions.
+*
+* \note This lives in its own file because VTK's OpenGL loader redefines the gl* entry points as macros,
+*       which breaks QOpenGLExtraFunctions in any file that also includes the VTK OpenGL headers.
+*/
+class QQuickVtkFrameExchange
+{
+public:
+    struct Frame
+    {
+        int slot = -1;
+        GLuint texture = 0;
+        QSize size;
+    };
+
+    // On the VTK render thread: copy the color attachment of 'framebuffer' into a free texture and publish it
+    void publish(GLuint framebuffer, const QSize& size);
+
+    // On the VTK render thread: delete all the OpenGL objects
+    void release();
+
+    // On the QML render thread: take the latest published frame, if there is a new one
+    bool acquire(Frame& frame);
+
+private:
+    struct Slot
+    {
+        GLuint texture = 0;
+        GLuint fbo = 0;
+        QSize size;
+        void* ready = nullptr;      // GLsync, set by the VTK render thread when the frame is written
+        void* released = nullptr;   // GLsync, set by the QML render thread when it stops compositing the frame
+    };
+
+    QMutex m_mutex;
+    Slot m_slots[3];
+    int m_published = -1;
+    int m_displayed = -1;
+};
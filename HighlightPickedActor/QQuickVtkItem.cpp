@@ -1,4 +1,7 @@
 #include "QQuickVtkItem.h"
+#include "QQuickVtkFrameExchange.h"
+#include "QQuickVtkTrace.h"
+#include "QQuickVtkTripleBuffer.h"
 
 #include <QtQuick/QSGTextureProvider>
 #include <QtQuick/QSGSimpleTextureNode>
@@ -6,30 +9,48 @@
 #include <QtQuick/QSGRenderNode>
 #include <QtQuick/QQuickWindow>
 
+#include <QtGui/QOffscreenSurface>
 #include <QtGui/QOpenGLContext>
 #include <QtGui/QScreen>
 
+#include <QtCore/QAbstractEventDispatcher>
+#include <QtCore/QAbstractItemModel>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QEvent>
 #include <QtCore/QMap>
+#include <QtCore/QMetaEnum>
+#include <QtCore/QMutex>
+#include <QtCore/QPointer>
 #include <QtCore/QQueue>
 #include <QtCore/QThread>
+#include <QtCore/QTimer>
 #include <QtCore/QRunnable>
 #include <QtCore/QSharedPointer>
+#include <QtCore/QWaitCondition>
 
+#include <vtkCamera.h>
+#include <vtkCommand.h>
 #include <vtkInteractorStyleTrackballCamera.h>
 #include <vtkGenericOpenGLRenderWindow.h>
+#include <vtkMath.h>
 #include <vtkOpenGLFramebufferObject.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkRendererCollection.h>
 #include <vtkTextureObject.h>
 #include <vtkOpenGLState.h>
+#include <vtkPropCollection.h>
 #include <vtkRenderer.h>
 
 #include <QVTKInteractorAdapter.h>
 #include <QVTKInteractor.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <limits>
 #include <queue>
+#include <utility>
 
 // no touch events for now
 #define NO_TOUCH
@@ -37,6 +58,14 @@
 /* -+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+- */
 
 class QSGVtkObjectNode;
+class QQuickVtkRenderThread;
+
+// Shared by the item and its node, so it outlives whichever of them goes first
+struct QQuickVtkSnapshots
+{
+    QQuickVtkTripleBuffer<QQuickVtkItem::Snapshot> buffer;
+    std::atomic<bool> notifyPending{false};
+};
 
 class QQuickVtkItemPrivate
 {
@@ -44,20 +73,252 @@ public:
     QQuickVtkItemPrivate(QQuickVtkItem* ptr) : q_ptr(ptr)
     {}
 
+    ~QQuickVtkItemPrivate()
+    {
+        delete surface;
+    }
+
     QQueue<std::function<void(vtkRenderWindow*, QQuickVtkItem::vtkUserData)>> asyncDispatch;
 
-    QVTKInteractorAdapter qt2vtkInteractorAdapter;
+    // Construction steps not handed over to the node yet
+    QQueue<std::function<double(vtkRenderWindow*, QQuickVtkItem::vtkUserData)>> incremental;
+    int constructionBudget = 8;
+    qreal constructionProgress = 1.0;
+
+    // Animations not handed over to the node yet, and the ones to stop
+    struct PendingAnimation { int id; QQuickVtkItem::Animation animation; };
+    QQueue<PendingAnimation> animations;
+    QVector<int> stoppedAnimations;
+    int lastAnimationId = 0;
+
+    // The latest snapshot read on the gui-thread, and the function adding the item's own state to them
+    QSharedPointer<QQuickVtkSnapshots> snapshots = QSharedPointer<QQuickVtkSnapshots>::create();
+    QQuickVtkItem::Snapshot snapshot;
+    std::function<void(QQuickVtkItem::Snapshot&, vtkRenderWindow*, QQuickVtkItem::vtkUserData)> snapshotFunction;
+    bool snapshotFunctionChanged = false;
+
+    // Shared with the queued event commands, which may still run on the VTK render thread after the item is gone
+    QSharedPointer<QVTKInteractorAdapter> qt2vtkInteractorAdapter = QSharedPointer<QVTKInteractorAdapter>::create();
 
     bool scheduleRender = false;
 
     mutable QSGVtkObjectNode* node = nullptr;
 
+    // With threadedRendering, the next node takes ownership of this surface
+    bool threadedRendering = false;
+    QOffscreenSurface* surface = nullptr;
+    void createSurface();
+
+    // The VTK render thread of the current node, owned by the node.  The commands already handed over to it are
+    // the only ones that can run without the item, the rest are run by updatePaintNode().
+    QPointer<QQuickVtkRenderThread> renderThread;
+    void discardCommands();
+
+    QPointer<QAbstractItemModel> model;
+    QVector<QMetaObject::Connection> modelConnections;
+    QString positionRole = QStringLiteral("position");
+    QString colorRole = QStringLiteral("color");
+    QString visibleRole = QStringLiteral("visible");
+    int positionRoleId = -1;
+    int colorRoleId = -1;
+    int visibleRoleId = -1;
+
+    // The model changes recorded since the last updatePolish()
+    struct DirtyRows { int first; int count; int roles; };
+    bool modelReset = false;
+    QVector<QQuickVtkItem::ModelUpdate::Op> modelOps;
+    QVector<DirtyRows> modelDirty;
+
+    void resolveModelRoles();
+    int modelRoles(const QVector<int>& roles) const;
+    void modelRowsInserted(int first, int count);
+    void modelRowsRemoved(int first, int count);
+    void modelRowsChanged(int first, int count, int roles);
+    void resetModelRows();
+    bool hasModelUpdate() const { return modelReset || !modelOps.isEmpty() || !modelDirty.isEmpty(); }
+    QQuickVtkItem::ModelUpdate takeModelUpdate();
+
 private:
     Q_DISABLE_COPY(QQuickVtkItemPrivate)
     Q_DECLARE_PUBLIC(QQuickVtkItem)
     QQuickVtkItem * const q_ptr;
 };
 
+void QQuickVtkItemPrivate::createSurface()
+{
+    Q_Q(QQuickVtkItem);
+
+    // A QOffscreenSurface may only be created on the gui-thread
+    if (surface || !threadedRendering || !q->window())
+        return;
+    surface = new QOffscreenSurface;
+    surface->setFormat(q->window()->format());
+    surface->create();
+}
+
+void QQuickVtkItemPrivate::discardCommands()
+{
+    if (renderThread)
+        renderThread->discardCommands();
+    renderThread = nullptr;
+}
+
+void QQuickVtkItemPrivate::resolveModelRoles()
+{
+    positionRoleId = colorRoleId = visibleRoleId = -1;
+    if (!model)
+        return;
+
+    const auto names = model->roleNames();
+    positionRoleId = names.key(positionRole.toUtf8(), -1);
+    colorRoleId = names.key(colorRole.toUtf8(), -1);
+    visibleRoleId = names.key(visibleRole.toUtf8(), -1);
+}
+
+int QQuickVtkItemPrivate::modelRoles(const QVector<int>& roles) const
+{
+    // An empty list means that every role may have changed
+    if (roles.isEmpty())
+        return QQuickVtkItem::ModelUpdate::AllRoles;
+
+    int mask = 0;
+    if (roles.contains(positionRoleId))
+        mask |= QQuickVtkItem::ModelUpdate::PositionRole;
+    if (roles.contains(colorRoleId))
+        mask |= QQuickVtkItem::ModelUpdate::ColorRole;
+    if (roles.contains(visibleRoleId))
+        mask |= QQuickVtkItem::ModelUpdate::VisibleRole;
+    return mask;
+}
+
+void QQuickVtkItemPrivate::resetModelRows()
+{
+    Q_Q(QQuickVtkItem);
+
+    // Without a model there are no rows to read again, and the item's own objects must stay as they are
+    if (!model)
+        return;
+    modelReset = true;
+    q->polish();
+}
+
+void QQuickVtkItemPrivate::modelRowsInserted(int first, int count)
+{
+    if (modelReset)
+        return;
+
+    // Renumber the rows changed so far, splitting any range the insertion falls into
+    QVector<DirtyRows> dirty;
+    for (auto r : std::as_const(modelDirty)) {
+        if (r.first >= first) {
+            r.first += count;
+            dirty << r;
+        } else if (r.first + r.count > first) {
+            dirty << DirtyRows{r.first, first - r.first, r.roles};
+            dirty << DirtyRows{first + count, r.first + r.count - first, r.roles};
+        } else {
+            dirty << r;
+        }
+    }
+    dirty << DirtyRows{first, count, QQuickVtkItem::ModelUpdate::AllRoles};
+    modelDirty.swap(dirty);
+
+    modelOps << QQuickVtkItem::ModelUpdate::Op{QQuickVtkItem::ModelUpdate::Op::Insert, first, count};
+}
+
+void QQuickVtkItemPrivate::modelRowsRemoved(int first, int count)
+{
+    if (modelReset)
+        return;
+
+    // Renumber the rows changed so far, dropping the removed ones
+    QVector<DirtyRows> dirty;
+    for (auto const& r : std::as_const(modelDirty)) {
+        const int end = r.first + r.count;
+        if (r.first < first)
+            dirty << DirtyRows{r.first, std::min(end, first) - r.first, r.roles};
+        if (end > first + count) {
+            const int begin = std::max(r.first, first + count);
+            dirty << DirtyRows{begin - count, end - begin, r.roles};
+        }
+    }
+    modelDirty.swap(dirty);
+
+    modelOps << QQuickVtkItem::ModelUpdate::Op{QQuickVtkItem::ModelUpdate::Op::Remove, first, count};
+}
+
+void QQuickVtkItemPrivate::modelRowsChanged(int first, int count, int roles)
+{
+    if (modelReset || !roles || count <= 0)
+        return;
+    modelDirty << DirtyRows{first, count, roles};
+}
+
+QQuickVtkItem::ModelUpdate QQuickVtkItemPrivate::takeModelUpdate()
+{
+    QQuickVtkItem::ModelUpdate update;
+    update.rowCount = model ? model->rowCount() : 0;
+
+    if (modelReset) {
+        update.reset = true;
+        modelDirty = {DirtyRows{0, update.rowCount, QQuickVtkItem::ModelUpdate::AllRoles}};
+    } else {
+        update.ops.swap(modelOps);
+    }
+
+    // Merge the overlapping ranges so that every row is read at most once
+    std::sort(modelDirty.begin(), modelDirty.end(), [](const DirtyRows& a, const DirtyRows& b) { return a.first < b.first; });
+    QVector<DirtyRows> merged;
+    for (auto const& r : std::as_const(modelDirty)) {
+        if (!merged.isEmpty() && r.first <= merged.last().first + merged.last().count) {
+            auto& m = merged.last();
+            m.count = std::max(m.first + m.count, r.first + r.count) - m.first;
+            m.roles |= r.roles;
+        } else {
+            merged << r;
+        }
+    }
+
+    // Read the values of the changed rows while we are on the gui-thread
+    int available = 0;
+    if (positionRoleId >= 0)
+        available |= QQuickVtkItem::ModelUpdate::PositionRole;
+    if (colorRoleId >= 0)
+        available |= QQuickVtkItem::ModelUpdate::ColorRole;
+    if (visibleRoleId >= 0)
+        available |= QQuickVtkItem::ModelUpdate::VisibleRole;
+
+    for (auto const& r : std::as_const(merged)) {
+        QQuickVtkItem::ModelUpdate::Changed c;
+        c.first = std::max(r.first, 0);
+        c.count = std::min(r.first + r.count, update.rowCount) - c.first;
+        c.roles = r.roles & available;
+        if (c.count <= 0 || !c.roles)
+            continue;
+        if (c.roles & QQuickVtkItem::ModelUpdate::PositionRole)
+            c.positions.reserve(c.count);
+        if (c.roles & QQuickVtkItem::ModelUpdate::ColorRole)
+            c.colors.reserve(c.count);
+        if (c.roles & QQuickVtkItem::ModelUpdate::VisibleRole)
+            c.visible.reserve(c.count);
+        for (int row = c.first; row < c.first + c.count; ++row) {
+            const auto index = model->index(row, 0);
+            if (c.roles & QQuickVtkItem::ModelUpdate::PositionRole)
+                c.positions << model->data(index, positionRoleId).value<QVector3D>();
+            if (c.roles & QQuickVtkItem::ModelUpdate::ColorRole)
+                c.colors << model->data(index, colorRoleId).value<QColor>();
+            if (c.roles & QQuickVtkItem::ModelUpdate::VisibleRole)
+                c.visible << model->data(index, visibleRoleId).toBool();
+        }
+        update.changed << c;
+    }
+
+    modelReset = false;
+    modelOps.clear();
+    modelDirty.clear();
+    return update;
+}
+
 /* -+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+- */
 
 QQuickVtkItem::QQuickVtkItem(QQuickItem* parent) : QQuickItem(parent), d_ptr(new QQuickVtkItemPrivate(this))
@@ -72,7 +333,13 @@ QQuickVtkItem::QQuickVtkItem(QQuickItem* parent) : QQuickItem(parent), d_ptr(new
     setFlag(QQuickItem::ItemHasContents);
 }
 
-QQuickVtkItem::~QQuickVtkItem() = default;
+QQuickVtkItem::~QQuickVtkItem()
+{
+    Q_D(QQuickVtkItem);
+
+    // The node, and its VTK render thread, may outlive the item until the scene graph gets to delete it
+    d->discardCommands();
+}
 
 void QQuickVtkItem::dispatch_async(std::function<void(vtkRenderWindow*, vtkUserData)> f)
 {
@@ -83,6 +350,379 @@ void QQuickVtkItem::dispatch_async(std::function<void(vtkRenderWindow*, vtkUserD
     update();
 }
 
+void QQuickVtkItem::dispatch_incremental(std::function<double(vtkRenderWindow*, vtkUserData)> step)
+{
+    Q_D(QQuickVtkItem);
+
+    d->incremental.append(step);
+
+    // A new build starts from scratch, the node reports its progress from the first frame it runs
+    const bool guiThread = QThread::currentThread() == thread();
+    if (d->constructionProgress != 0) {
+        d->constructionProgress = 0;
+        if (guiThread)
+            Q_EMIT constructionProgressChanged();
+        else
+            QMetaObject::invokeMethod(this, &QQuickVtkItem::constructionProgressChanged, Qt::QueuedConnection);
+    }
+
+    // From initializeVTK() the steps are picked up by the ongoing updatePaintNode()
+    if (guiThread)
+        update();
+}
+
+int QQuickVtkItem::animate(Animation animation)
+{
+    Q_D(QQuickVtkItem);
+
+    const int id = ++d->lastAnimationId;
+    d->animations.enqueue({id, std::move(animation)});
+
+    update();
+    return id;
+}
+
+void QQuickVtkItem::stopAnimation(int id)
+{
+    Q_D(QQuickVtkItem);
+
+    // Not handed over to the node yet, so just drop it
+    auto pending = std::find_if(d->animations.begin(), d->animations.end(),
+                                [id](const QQuickVtkItemPrivate::PendingAnimation& p) { return p.id == id; });
+    if (pending != d->animations.end()) {
+        d->animations.erase(pending);
+        return;
+    }
+
+    d->stoppedAnimations.append(id);
+    update();
+}
+
+int QQuickVtkItem::tween(qreal seconds, std::function<void(double, vtkRenderWindow*, vtkUserData)> apply)
+{
+    return animate([seconds, apply = std::move(apply)](double t, vtkRenderWindow* renderWindow, vtkUserData userData) {
+        const double x = seconds > 0 ? std::min(t / seconds, 1.0) : 1.0;
+        apply(x * x * (3 - 2 * x), renderWindow, userData);
+        return x < 1.0;
+    });
+}
+
+int QQuickVtkItem::orbitCamera(qreal degreesPerSecond, qreal seconds)
+{
+    return animate([degreesPerSecond, seconds, done = 0.0](double t, vtkRenderWindow* renderWindow, vtkUserData) mutable {
+        auto renderer = renderWindow->GetRenderers()->GetFirstRenderer();
+        if (!renderer)
+            return false;
+        if (seconds > 0)
+            t = std::min(t, double(seconds));
+
+        // From the time rather than per frame, so a late frame catches up instead of slowing the orbit down
+        const double angle = degreesPerSecond * t;
+        renderer->GetActiveCamera()->Azimuth(angle - std::exchange(done, angle));
+        renderer->ResetCameraClippingRange();
+        return seconds <= 0 || t < seconds;
+    });
+}
+
+int QQuickVtkItem::flyCamera(const QVector3D& position, const QVector3D& focalPoint, qreal seconds)
+{
+    const std::array<double, 6> to = {position.x(), position.y(), position.z(), focalPoint.x(), focalPoint.y(), focalPoint.z()};
+    return tween(seconds, [to, from = std::array<double, 6>(), started = false](double t, vtkRenderWindow* renderWindow, vtkUserData) mutable {
+        auto renderer = renderWindow->GetRenderers()->GetFirstRenderer();
+        if (!renderer)
+            return;
+        auto camera = renderer->GetActiveCamera();
+
+        // From wherever the camera is when the flight starts
+        if (!std::exchange(started, true)) {
+            camera->GetPosition(from.data());
+            camera->GetFocalPoint(from.data() + 3);
+        }
+
+        std::array<double, 6> at;
+        for (size_t i = 0; i < at.size(); ++i)
+            at[i] = from[i] + t * (to[i] - from[i]);
+        camera->SetPosition(at.data());
+        camera->SetFocalPoint(at.data() + 3);
+        camera->OrthogonalizeViewUp();
+        renderer->ResetCameraClippingRange();
+    });
+}
+
+QQuickVtkItem::Snapshot QQuickVtkItem::snapshot() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot;
+}
+
+int QQuickVtkItem::frameCount() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot.frame;
+}
+
+qreal QQuickVtkItem::frameTime() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot.frameTime;
+}
+
+QVector3D QQuickVtkItem::cameraPosition() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot.cameraPosition;
+}
+
+QVector3D QQuickVtkItem::cameraFocalPoint() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot.cameraFocalPoint;
+}
+
+QVector3D QQuickVtkItem::cameraViewUp() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot.cameraViewUp;
+}
+
+qreal QQuickVtkItem::cameraViewAngle() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot.cameraViewAngle;
+}
+
+QVector3D QQuickVtkItem::sceneBoundsMin() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot.boundsMin;
+}
+
+QVector3D QQuickVtkItem::sceneBoundsMax() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot.boundsMax;
+}
+
+int QQuickVtkItem::pickedId() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot.pickedId;
+}
+
+QVector3D QQuickVtkItem::pickedCenter() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot.pickedCenter;
+}
+
+int QQuickVtkItem::propsRendered() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->snapshot.propsRendered;
+}
+
+void QQuickVtkItem::setSnapshotFunction(std::function<void(Snapshot&, vtkRenderWindow*, vtkUserData)> function)
+{
+    Q_D(QQuickVtkItem);
+
+    d->snapshotFunction = std::move(function);
+    d->snapshotFunctionChanged = true;
+
+    // From initializeVTK() it is picked up by the ongoing updatePaintNode()
+    if (QThread::currentThread() == thread())
+        update();
+}
+
+int QQuickVtkItem::constructionBudget() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->constructionBudget;
+}
+
+void QQuickVtkItem::setConstructionBudget(int milliseconds)
+{
+    Q_D(QQuickVtkItem);
+
+    if (d->constructionBudget == milliseconds)
+        return;
+    d->constructionBudget = milliseconds;
+    update();
+    Q_EMIT constructionBudgetChanged();
+}
+
+qreal QQuickVtkItem::constructionProgress() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->constructionProgress;
+}
+
+bool QQuickVtkItem::threadedRendering() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->threadedRendering;
+}
+
+void QQuickVtkItem::setThreadedRendering(bool threaded)
+{
+    Q_D(QQuickVtkItem);
+
+    if (d->threadedRendering == threaded)
+        return;
+    d->threadedRendering = threaded;
+    d->createSurface();
+    Q_EMIT threadedRenderingChanged();
+}
+
+void QQuickVtkItem::itemChange(ItemChange change, const ItemChangeData& value)
+{
+    QQuickItem::itemChange(change, value);
+
+    if (change == ItemSceneChange && value.window) {
+        Q_D(QQuickVtkItem);
+        d->createSurface();
+    }
+}
+
+QAbstractItemModel* QQuickVtkItem::model() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->model;
+}
+
+void QQuickVtkItem::setModel(QAbstractItemModel* model)
+{
+    Q_D(QQuickVtkItem);
+
+    if (d->model == model)
+        return;
+
+    for (auto const& c : std::as_const(d->modelConnections))
+        disconnect(c);
+    d->modelConnections.clear();
+
+    d->model = model;
+
+    if (model) {
+        auto reset = [d, this] {
+            d->resolveModelRoles();
+            d->modelReset = true;
+            polish();
+        };
+        d->modelConnections
+            << connect(model, &QAbstractItemModel::dataChanged, this,
+                [d, this](const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles) {
+                    if (topLeft.parent().isValid())
+                        return;
+                    d->modelRowsChanged(topLeft.row(), bottomRight.row() - topLeft.row() + 1, d->modelRoles(roles));
+                    polish();
+                })
+            << connect(model, &QAbstractItemModel::rowsInserted, this,
+                [d, this](const QModelIndex& parent, int first, int last) {
+                    if (parent.isValid())
+                        return;
+                    d->modelRowsInserted(first, last - first + 1);
+                    polish();
+                })
+            << connect(model, &QAbstractItemModel::rowsRemoved, this,
+                [d, this](const QModelIndex& parent, int first, int last) {
+                    if (parent.isValid())
+                        return;
+                    d->modelRowsRemoved(first, last - first + 1);
+                    polish();
+                })
+            << connect(model, &QAbstractItemModel::rowsMoved, this,
+                [d, this](const QModelIndex& parent, int first, int last, const QModelIndex& destination, int row) {
+                    // A removal then an insertion, so only the moved rows are read again
+                    const int count = last - first + 1;
+                    if (!parent.isValid())
+                        d->modelRowsRemoved(first, count);
+                    if (!destination.isValid())
+                        d->modelRowsInserted(!parent.isValid() && row > first ? row - count : row, count);
+                    if (!parent.isValid() || !destination.isValid())
+                        polish();
+                })
+            << connect(model, &QAbstractItemModel::layoutChanged, this, reset)
+            << connect(model, &QAbstractItemModel::modelReset, this, reset)
+            << connect(model, &QObject::destroyed, this, [d, this] {
+                   // The QPointer is already cleared, so just drop the connections and all the rows
+                   d->modelConnections.clear();
+                   d->resolveModelRoles();
+                   d->modelReset = true;
+                   polish();
+                   Q_EMIT modelChanged();
+               });
+    }
+
+    // A new model replaces all the rows
+    d->resolveModelRoles();
+    d->modelReset = true;
+    polish();
+
+    Q_EMIT modelChanged();
+}
+
+QString QQuickVtkItem::positionRole() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->positionRole;
+}
+
+void QQuickVtkItem::setPositionRole(const QString& role)
+{
+    Q_D(QQuickVtkItem);
+    if (d->positionRole == role)
+        return;
+    d->positionRole = role;
+    d->resolveModelRoles();
+    d->resetModelRows();
+    Q_EMIT positionRoleChanged();
+}
+
+QString QQuickVtkItem::colorRole() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->colorRole;
+}
+
+void QQuickVtkItem::setColorRole(const QString& role)
+{
+    Q_D(QQuickVtkItem);
+    if (d->colorRole == role)
+        return;
+    d->colorRole = role;
+    d->resolveModelRoles();
+    d->resetModelRows();
+    Q_EMIT colorRoleChanged();
+}
+
+QString QQuickVtkItem::visibleRole() const
+{
+    Q_D(const QQuickVtkItem);
+    return d->visibleRole;
+}
+
+void QQuickVtkItem::setVisibleRole(const QString& role)
+{
+    Q_D(QQuickVtkItem);
+    if (d->visibleRole == role)
+        return;
+    d->visibleRole = role;
+    d->resolveModelRoles();
+    d->resetModelRows();
+    Q_EMIT visibleRoleChanged();
+}
+
+void QQuickVtkItem::updatePolish()
+{
+    QQUICKVTK_TRACE_SCOPE("updatePolish");
+
+    Q_D(QQuickVtkItem);
+
+    // Hand over all of this frame's model changes at once
+    if (d->hasModelUpdate())
+        modelUpdated(d->takeModelUpdate());
+}
+
 #if 0
 void QQuickVtkItem::qtRect2vtkViewport(QRectF const& qtRect, double vtkViewport[4], QRectF* glRect)
 {
@@ -106,6 +746,151 @@ void QQuickVtkItem::qtRect2vtkViewport(QRectF const& qtRect, double vtkViewport[
 }
 #endif
 
+namespace {
+QSGTexture* wrapTexture(QQuickWindow* window, GLuint texId, const QSize& size)
+{
+#if QT_VERSION < QT_VERSION_CHECK(6,0,0)
+    return window->createTextureFromNativeObject(QQuickWindow::NativeObjectTexture, &texId, 0, size, QQuickWindow::TextureHasAlphaChannel);
+#else
+    return QNativeInterface::QSGOpenGLTexture::fromNative(texId, window, size, QQuickWindow::TextureHasAlphaChannel);
+#endif
+}
+}
+
+/**
+* The VTK render thread of an item with threadedRendering.
+*
+* VTK renders into its own framebuffer on this thread with an OpenGL context shared with the QML render thread,
+* and every finished frame is published through a QQuickVtkFrameExchange.
+*
+* The QVTKInteractor, and so its timers, live on this thread.  It waits for work in its event dispatcher rather than
+* on a condition, so the interactor timers fire between frames as they would on the QML render thread.
+*/
+class QQuickVtkRenderThread : public QThread
+{
+    Q_OBJECT
+public:
+    using Command = std::function<void(vtkRenderWindow*, QQuickVtkItem::vtkUserData)>;
+
+    // Called on the qt-render-thread, with the QML OpenGL context current
+    QQuickVtkRenderThread(QSGVtkObjectNode* node, QOpenGLContext* shareContext, QOffscreenSurface* surface)
+        : m_node(node), m_surface(surface)
+    {
+        setObjectName(QStringLiteral("QQuickVtkRenderThread"));
+        m_context = new QOpenGLContext;
+        m_context->setFormat(shareContext->format());
+        m_context->setShareContext(shareContext);
+        m_context->create();
+        m_context->moveToThread(this);
+    }
+
+    /**
+    * Starts the thread and runs initializeVTK() on it while the qt-render-thread, and so the gui-thread, waits
+    *
+    * \return false if the shared OpenGL context couldn't be created or made current on this thread, the thread has
+    *         then finished (or never started) without touching the item and the caller should render on the
+    *         qt-render-thread instead
+    */
+    bool initialize(QQuickVtkItem* item)
+    {
+        if (!m_context->isValid()) {
+            qWarning().nospace() << "QQuickVTKItem.cpp:" << __LINE__ << ", YIKES!! Could not create an OpenGL context shared with the QML one";
+            releaseContext();
+            return false;
+        }
+        start();
+
+        QMutexLocker lock(&m_mutex);
+        m_initItem = item;
+        wake();
+        while (!m_initDone)
+            m_initialized.wait(&m_mutex);
+        return !m_initFailed;
+    }
+
+    // Drops the commands not run yet and waits for the ones running, from then on none of them touches the item
+    void discardCommands()
+    {
+        QMutexLocker lock(&m_mutex);
+        m_commands.clear();
+        while (m_runningCommands)
+            m_commandsDone.wait(&m_mutex);
+    }
+
+    /**
+    * Called from updatePaintNode(), with the gui-thread blocked.  Hands this frame's commands and size over and
+    * shows the latest frame the VTK render thread has finished, never waits for it.
+    */
+    void synchronize(QQuickVtkItem* item, QQueue<Command>& commands, bool render);
+
+    // Releases the VTK objects on this thread and joins it
+    void stop()
+    {
+        {
+            QMutexLocker lock(&m_mutex);
+            m_stop = true;
+            wake();
+        }
+        wait();
+    }
+
+Q_SIGNALS:
+    void frameReady();
+
+protected:
+    void run() override;
+
+private:
+    void renderFrame();
+
+    // The context and the surface are only ever used by this thread, so they go with it when it finishes
+    void releaseContext()
+    {
+        delete m_context;
+        m_context = nullptr;
+
+        // The surface belongs to the gui-thread
+        m_surface->deleteLater();
+    }
+
+    // Wakes the VTK render thread up from its event loop, call with m_mutex locked
+    void wake()
+    {
+        if (auto dispatcher = eventDispatcher())
+            dispatcher->wakeUp();
+    }
+
+    // A timer of the interactor fired, show what its observers changed
+    void interactorTimer(vtkObject*, unsigned long, void*)
+    {
+        QMutexLocker lock(&m_mutex);
+        m_renderRequested = true;
+    }
+
+    QSGVtkObjectNode* m_node;
+    QOpenGLContext* m_context = nullptr;
+    QOffscreenSurface* m_surface;
+
+    QMutex m_mutex;
+    QWaitCondition m_initialized;
+    QQuickVtkItem* m_initItem = nullptr;
+    bool m_initDone = false;
+    bool m_initFailed = false;
+    QQueue<Command> m_commands;
+    bool m_runningCommands = false;
+    QWaitCondition m_commandsDone;
+    QSize m_size;
+    bool m_renderRequested = false;
+    bool m_stop = false;
+    QQuickVtkFrameExchange m_frames;
+
+    std::atomic<int> m_frameInterval{16};
+
+    // Only touched by the VTK render thread
+    QSize m_vtkSize;
+    QDeadlineTimer m_animationDeadline{QDeadlineTimer::Forever};
+};
+
 class QSGVtkObjectNode : public QSGTextureProvider, public QSGSimpleTextureNode
 {
     Q_OBJECT
@@ -113,12 +898,36 @@ public:
     QSGVtkObjectNode() 
     {
         qsgnode_set_description(this, QStringLiteral("vtknode"));
+        m_clock.start();
     }
 
     ~QSGVtkObjectNode()
     {
+        if (m_thread) {
+            for (auto texture : m_slotTextures)
+                delete texture;
+
+            // The VTK objects are released on their own thread
+            m_thread->stop();
+            delete m_thread;
+            return;
+        }
+
         delete QSGVtkObjectNode::texture();
 
+        releaseVtk();
+    }
+
+    QSGTexture* texture() const override
+    {
+        return QSGSimpleTextureNode::texture();
+    }
+
+    void releaseVtk()
+    {
+        if (!vtkWindow)
+            return;
+
         // Cleanup the VTK window resources
         vtkWindow->GetRenderers()->InitTraversal(); while (auto renderer = vtkWindow->GetRenderers()->GetNextItem())
             renderer->ReleaseGraphicsResources(vtkWindow);
@@ -129,11 +938,6 @@ public:
         vtkUserData = nullptr;
     }
 
-    QSGTexture* texture() const override
-    {
-        return QSGSimpleTextureNode::texture();
-    }
-
     void initialize(QQuickVtkItem* item)
     {
         // Create and initialize the vtkWindow
@@ -145,7 +949,10 @@ public:
         iren->SetRenderWindow(vtkWindow);
         vtkNew<vtkInteractorStyleTrackballCamera> style;
         iren->SetInteractorStyle(style);
-        vtkUserData = item->initializeVTK(vtkWindow);
+        {
+            QQUICKVTK_TRACE_SCOPE("initializeVTK");
+            vtkUserData = item->initializeVTK(vtkWindow);
+        }
         if (auto ia = vtkWindow->GetInteractor(); ia && !QVTKInteractor::SafeDownCast(ia)) {
             qWarning().nospace() << "QQuickVTKItem.cpp:" << __LINE__ << ", YIKES!! Only QVTKInteractor is supported";
             return;
@@ -168,35 +975,181 @@ public:
         m_window->update();
     }
 
+    // Runs the construction steps for at most the budget, returns true while there is more to do
+    bool runConstruction()
+    {
+        if (m_steps.isEmpty())
+            return false;
+
+        QQUICKVTK_TRACE_SCOPE("construction", "steps", m_steps.size());
+        QElapsedTimer timer;
+        timer.start();
+        const qint64 budget = qint64(m_constructionBudget) * 1000;
+        do {
+            const double progress = m_steps.head()(vtkWindow, vtkUserData);
+            if (progress >= 1.0) {
+                m_steps.dequeue();
+                ++m_stepsDone;
+                m_stepProgress = 0;
+            } else {
+                m_stepProgress = std::max(progress, 0.0);
+            }
+        } while (!m_steps.isEmpty() && timer.nsecsElapsed() < budget);
+
+        const double progress = m_steps.isEmpty() ? 1.0 : (m_stepsDone + m_stepProgress) / (m_stepsDone + m_steps.size());
+        if (m_steps.isEmpty())
+            m_stepsDone = 0;
+        Q_EMIT constructionProgressChanged(progress);
+
+        return !m_steps.isEmpty();
+    }
+
+    // Advances the animations to the time of this frame, returns true while any of them is still running
+    bool runAnimations()
+    {
+        if (m_animations.isEmpty())
+            return false;
+
+        QQUICKVTK_TRACE_SCOPE("animations", "count", m_animations.size());
+        const double now = m_clock.nsecsElapsed() * 1e-9;
+        for (int i = 0; i < m_animations.size();) {
+            auto& animation = m_animations[i];
+            if (animation.start < 0)
+                animation.start = now;
+            if (animation.animation(now - animation.start, vtkWindow, vtkUserData)) {
+                ++i;
+                continue;
+            }
+            Q_EMIT animationFinished(animation.id);
+            m_animations.removeAt(i);
+        }
+
+        return !m_animations.isEmpty();
+    }
+
+    void removeAnimation(int id)
+    {
+        m_animations.erase(std::remove_if(m_animations.begin(), m_animations.end(),
+                                          [id](const RunningAnimation& animation) { return animation.id == id; }),
+                           m_animations.end());
+    }
+
+    // Render VTK into it's framebuffer, on whichever thread owns the VTK objects
+    void renderVtk()
+    {
+        auto ostate = vtkWindow->GetState();
+        ostate->Reset();
+        ostate->Push();
+        ostate->vtkglDepthFunc(GL_LEQUAL);          // note: By default, Qt sets the depth function to GL_LESS but VTK expects GL_LEQUAL
+        vtkWindow->SetReadyForRendering(true);
+        vtkWindow->GetInteractor()->ProcessEvents();
+        QElapsedTimer timer;
+        timer.start();
+        {
+            QQUICKVTK_TRACE_SCOPE("vtkRender");
+            vtkWindow->GetInteractor()->Render();
+        }
+        const double frameTime = timer.nsecsElapsed() * 1e-6;
+        vtkWindow->SetReadyForRendering(false);
+        ostate->Pop();
+
+        publishSnapshot(frameTime);
+    }
+
+    // Publishes the state after this frame for the gui-thread, see QQuickVtkItem::snapshot()
+    void publishSnapshot(double frameTime)
+    {
+        if (!m_snapshots)
+            return;
+
+        QQUICKVTK_TRACE_SCOPE("snapshot");
+        auto& snapshot = m_snapshots->buffer.back();
+        snapshot = QQuickVtkItem::Snapshot();
+        snapshot.frame = ++m_frameCount;
+        snapshot.frameTime = frameTime;
+        snapshot.size = QSize(vtkWindow->GetSize()[0], vtkWindow->GetSize()[1]);
+        if (auto renderer = vtkWindow->GetRenderers()->GetFirstRenderer()) {
+            auto toVector = [](const double* v) { return QVector3D(float(v[0]), float(v[1]), float(v[2])); };
+            auto camera = renderer->GetActiveCamera();
+            snapshot.cameraPosition = toVector(camera->GetPosition());
+            snapshot.cameraFocalPoint = toVector(camera->GetFocalPoint());
+            snapshot.cameraViewUp = toVector(camera->GetViewUp());
+            snapshot.cameraViewAngle = camera->GetViewAngle();
+            snapshot.propsRendered = renderer->GetNumberOfPropsRendered();
+
+            updateBounds(renderer);
+            snapshot.hasBounds = m_hasBounds;
+            snapshot.boundsMin = m_boundsMin;
+            snapshot.boundsMax = m_boundsMax;
+        }
+        if (m_snapshotFunction)
+            m_snapshotFunction(snapshot, vtkWindow, vtkUserData);
+        m_snapshots->buffer.publish();
+
+        // One notification at a time is enough, the gui-thread always reads the latest snapshot
+        if (!m_snapshots->notifyPending.exchange(true))
+            Q_EMIT snapshotPublished();
+    }
+
+    // The bounds of the visible props, only recomputed when the renderer or one of its props has changed since
+    void updateBounds(vtkRenderer* renderer)
+    {
+        // The redraw time of a prop covers its mapper and input too, which is where its bounds come from
+        vtkMTimeType time = renderer->GetMTime();
+        auto props = renderer->GetViewProps();
+        vtkCollectionSimpleIterator it;
+        props->InitTraversal(it);
+        while (auto prop = props->GetNextProp(it))
+            time = std::max(time, prop->GetRedrawMTime());
+        if (renderer == m_boundsRenderer && time == m_boundsTime && props->GetNumberOfItems() == m_boundsProps)
+            return;
+        m_boundsRenderer = renderer;
+        m_boundsTime = time;
+        m_boundsProps = props->GetNumberOfItems();
+
+        QQUICKVTK_TRACE_SCOPE("bounds", "props", m_boundsProps);
+        double bounds[6];
+        renderer->ComputeVisiblePropBounds(bounds);
+        m_hasBounds = vtkMath::AreBoundsInitialized(bounds);
+        if (m_hasBounds) {
+            m_boundsMin = QVector3D(float(bounds[0]), float(bounds[2]), float(bounds[4]));
+            m_boundsMax = QVector3D(float(bounds[1]), float(bounds[3]), float(bounds[5]));
+        }
+    }
+
 public Q_SLOTS:
     void render()
     {
         if (m_renderPending) {
+            QQUICKVTK_TRACE_SCOPE("render");
             m_renderPending = false;
 
             const bool needsWrap = QSGRendererInterface::isApiRhiBased(m_window->rendererInterface()->graphicsApi());
             if (needsWrap)
                 m_window->beginExternalCommands();
 
-            // Render VTK into it's framebuffer
-            auto ostate = vtkWindow->GetState();
-            ostate->Reset();
-            ostate->Push();
-            ostate->vtkglDepthFunc(GL_LEQUAL);          // note: By default, Qt sets the depth function to GL_LESS but VTK expects GL_LEQUAL
-            vtkWindow->SetReadyForRendering(true);
-            vtkWindow->GetInteractor()->ProcessEvents();
-            vtkWindow->GetInteractor()->Render();
-            vtkWindow->SetReadyForRendering(false);
-            ostate->Pop();
+            const bool constructing = runConstruction();
+            const bool animating = runAnimations();
+            renderVtk();
 
             if (needsWrap)
                 m_window->endExternalCommands();
 
             markDirty(QSGNode::DirtyMaterial);
             Q_EMIT textureChanged();
+
+            // Show the partial scene, or this step of the animations, now and carry on with the next frame
+            if (constructing || animating)
+                scheduleRender();
         }
     }
 
+Q_SIGNALS:
+    void constructionProgressChanged(double progress);
+    void animationFinished(int id);
+    void snapshotPublished();
+
+public Q_SLOTS:
     void handleScreenChange()
     {
         if (m_window->effectiveDevicePixelRatio() != m_devicePixelRatio) {
@@ -210,6 +1163,38 @@ private:
     vtkSmartPointer<vtkObject> vtkUserData;
     bool m_renderPending = false;
 
+    // Construction steps from dispatch_incremental(), only touched by the thread that owns the VTK objects
+    QQueue<std::function<double(vtkRenderWindow*, QQuickVtkItem::vtkUserData)>> m_steps;
+    int m_stepsDone = 0;
+    double m_stepProgress = 0;
+    std::atomic<int> m_constructionBudget{8};
+
+    // Animations from animate(), only touched by the thread that owns the VTK objects
+    struct RunningAnimation
+    {
+        int id;
+        QQuickVtkItem::Animation animation;
+        double start;                       // on m_clock, -1 until the first frame
+    };
+    QVector<RunningAnimation> m_animations;
+    QElapsedTimer m_clock;
+
+    // Written by the thread that owns the VTK objects
+    QSharedPointer<QQuickVtkSnapshots> m_snapshots;
+    std::function<void(QQuickVtkItem::Snapshot&, vtkRenderWindow*, QQuickVtkItem::vtkUserData)> m_snapshotFunction;
+    int m_frameCount = 0;
+    vtkRenderer* m_boundsRenderer = nullptr;    // only compared, never dereferenced
+    vtkMTimeType m_boundsTime = 0;
+    int m_boundsProps = 0;
+    bool m_hasBounds = false;
+    QVector3D m_boundsMin;
+    QVector3D m_boundsMax;
+
+    // Only with threadedRendering
+    QQuickVtkRenderThread* m_thread = nullptr;
+    QSGTexture* m_slotTextures[3] = {};
+    friend class QQuickVtkRenderThread;
+
 protected:
     // variables set in QQuickVtkItem::updatePaintNode()
     QQuickWindow* m_window = nullptr;
@@ -219,8 +1204,177 @@ protected:
     friend class QQuickVtkItem;
 };
 
+void QQuickVtkRenderThread::run()
+{
+    if (!m_context->isValid() || !m_context->makeCurrent(m_surface)) {
+        qWarning().nospace() << "QQuickVTKItem.cpp:" << __LINE__ << ", YIKES!! Could not make the shared OpenGL context current on the VTK render thread";
+        releaseContext();
+
+        QMutexLocker lock(&m_mutex);
+        m_initFailed = true;
+        m_initDone = true;
+        m_initialized.wakeAll();
+        return;
+    }
+
+    auto dispatcher = eventDispatcher();
+    QTimer animationTimer;
+    animationTimer.setSingleShot(true);
+    animationTimer.setTimerType(Qt::PreciseTimer);
+
+    forever {
+        // The interactor timers, and anything else posted to the objects of this thread
+        dispatcher->processEvents(QEventLoop::AllEvents);
+
+        QQuickVtkItem* initItem = nullptr;
+        QQueue<Command> commands;
+        QSize size;
+        bool render = false;
+        {
+            QMutexLocker lock(&m_mutex);
+            if (m_animationDeadline.hasExpired()) {
+                m_animationDeadline = QDeadlineTimer(QDeadlineTimer::Forever);
+                m_renderRequested = true;
+            }
+            if (m_stop)
+                break;
+            if (!m_initItem && !m_renderRequested && m_commands.isEmpty()) {
+                lock.unlock();
+
+                // Sleep until woken up, a timer fires or running animations want the next frame
+                if (!m_animationDeadline.isForever())
+                    animationTimer.start(int(m_animationDeadline.remainingTime()));
+                dispatcher->processEvents(QEventLoop::WaitForMoreEvents);
+                animationTimer.stop();
+                continue;
+            }
+            initItem = std::exchange(m_initItem, nullptr);
+            commands.swap(m_commands);
+            m_runningCommands = !commands.isEmpty();
+            size = m_size;
+            render = std::exchange(m_renderRequested, false) || !commands.isEmpty();
+        }
+
+        if (initItem) {
+            m_node->initialize(initItem);
+            if (auto interactor = m_node->vtkWindow->GetInteractor())
+                interactor->AddObserver(vtkCommand::TimerEvent, this, &QQuickVtkRenderThread::interactorTimer);
+            QMutexLocker lock(&m_mutex);
+            m_initDone = true;
+            m_initialized.wakeAll();
+        }
+
+        auto vtkWindow = m_node->vtkWindow.Get();
+        if (!vtkWindow) {
+            // Nothing to run them on, initializeVTK() failed
+            commands.clear();
+            QMutexLocker lock(&m_mutex);
+            m_runningCommands = false;
+            m_commandsDone.wakeAll();
+            continue;
+        }
+
+        if (size != m_vtkSize && !size.isEmpty()) {
+            QQUICKVTK_TRACE_SCOPE("SetSize", "width", size.width());
+            vtkWindow->SetSize(size.width(), size.height());
+            vtkWindow->GetInteractor()->SetSize(vtkWindow->GetSize());
+            m_vtkSize = size;
+            render = true;
+        }
+
+        if (!commands.isEmpty()) {
+            QQUICKVTK_TRACE_SCOPE("asyncDispatch", "commands", commands.size());
+            vtkWindow->SetReadyForRendering(true);
+            while (!commands.isEmpty())
+                commands.dequeue()(vtkWindow, m_node->vtkUserData);
+            vtkWindow->SetReadyForRendering(false);
+
+            QMutexLocker lock(&m_mutex);
+            m_runningCommands = false;
+            m_commandsDone.wakeAll();
+        }
+
+        if (render && !m_vtkSize.isEmpty())
+            renderFrame();
+    }
+
+    m_node->releaseVtk();
+    m_frames.release();
+    m_context->doneCurrent();
+    releaseContext();
+}
+
+void QQuickVtkRenderThread::renderFrame()
+{
+    QQUICKVTK_TRACE_SCOPE("render");
+
+    const QDeadlineTimer nextFrame(m_frameInterval.load());
+
+    // Show the partial scene now and carry on with the next frame
+    if (m_node->runConstruction()) {
+        QMutexLocker lock(&m_mutex);
+        m_renderRequested = true;
+    }
+
+    // The animations carry on at the display's frame rate, not as fast as this thread can render
+    m_animationDeadline = m_node->runAnimations() ? nextFrame : QDeadlineTimer(QDeadlineTimer::Forever);
+
+    m_node->renderVtk();
+
+    auto fb = m_node->vtkWindow->GetDisplayFramebuffer();
+    if (!fb) {
+        qWarning().nospace() << "QQuickVTKItem.cpp:" << __LINE__ << ", YIKES!!, Render() didn't create a FrameBuffer!?";
+        return;
+    }
+    {
+        QQUICKVTK_TRACE_SCOPE("publish");
+        m_frames.publish(fb->GetFBOIndex(), m_vtkSize);
+    }
+
+    Q_EMIT frameReady();
+}
+
+void QQuickVtkRenderThread::synchronize(QQuickVtkItem* item, QQueue<Command>& commands, bool render)
+{
+    auto window = item->window();
+    m_node->m_devicePixelRatio = window->devicePixelRatio();
+    auto sz = item->size() * m_node->m_devicePixelRatio;
+    render |= sz != m_node->size || !commands.isEmpty();
+    m_node->size = sz;
+
+    // The pace of the animations, the VTK render thread has no vsync of its own
+    if (auto screen = window->screen(); screen && screen->refreshRate() > 0)
+        m_frameInterval = qRound(1000 / screen->refreshRate());
+
+    {
+        QQUICKVTK_TRACE_SCOPE("asyncDispatch", "commands", commands.size());
+        QMutexLocker lock(&m_mutex);
+        while (!commands.isEmpty())
+            m_commands.enqueue(commands.dequeue());
+        m_size = sz.toSize();
+        m_renderRequested |= render;
+        wake();
+    }
+
+    // Composite the latest finished frame, if there is a new one
+    QQuickVtkFrameExchange::Frame frame;
+    if (m_frames.acquire(frame)) {
+        QQUICKVTK_TRACE_SCOPE("textureRewrap");
+        auto& texture = m_node->m_slotTextures[frame.slot];
+        if (!texture || texture->textureSize() != frame.size) {
+            delete texture;
+            texture = wrapTexture(window, frame.texture, frame.size);
+        }
+        m_node->setTexture(texture);
+        m_node->markDirty(QSGNode::DirtyMaterial);
+        Q_EMIT m_node->textureChanged();
+    }
+}
+
 QSGNode* QQuickVtkItem::updatePaintNode(QSGNode* node, UpdatePaintNodeData*)
 {
+    QQUICKVTK_TRACE_SCOPE("updatePaintNode");
+
     auto* n = static_cast<QSGVtkObjectNode*>(node);
     
     // Don't create the node if our size is invalid
@@ -244,11 +1398,84 @@ QSGNode* QQuickVtkItem::updatePaintNode(QSGNode* node, UpdatePaintNodeData*)
         
     // Initialize the QSGRenderNode
     if (!n->m_item) {
-        n->initialize(this);
+        n->m_snapshots = d->snapshots;
+        auto shareContext = QOpenGLContext::currentContext();
+        if (d->threadedRendering && shareContext && d->surface) {
+            auto thread = new QQuickVtkRenderThread(n, shareContext, std::exchange(d->surface, nullptr));
+            if (thread->initialize(this)) {
+                n->m_thread = thread;
+                connect(thread, &QQuickVtkRenderThread::frameReady, this, &QQuickItem::update, Qt::QueuedConnection);
+                d->renderThread = thread;
+            } else {
+                thread->wait();
+                delete thread;
+            }
+
+            // Have a surface ready for the next node, should the scene graph recreate it
+            QMetaObject::invokeMethod(this, [d] { d->createSurface(); }, Qt::QueuedConnection);
+        } else if (d->threadedRendering) {
+            qWarning().nospace() << "QQuickVTKItem.cpp:" << __LINE__ << ", YIKES!! No OpenGL context or surface to share";
+        }
+        if (!n->m_thread) {
+            if (d->threadedRendering)
+                qWarning().nospace() << "QQuickVTKItem.cpp:" << __LINE__ << ", YIKES!! Rendering on the QML render thread instead";
+            n->initialize(this);
+            connect(window(), &QQuickWindow::beforeRendering, n, &QSGVtkObjectNode::render);
+        }
         n->m_window = window();
         n->m_item = this;
-        connect(window(), &QQuickWindow::beforeRendering, n, &QSGVtkObjectNode::render);
         connect(window(), &QQuickWindow::screenChanged, n, &QSGVtkObjectNode::handleScreenChange);
+        connect(n, &QSGVtkObjectNode::constructionProgressChanged, this, [d, this](double progress) {
+            if (d->constructionProgress != progress) {
+                d->constructionProgress = progress;
+                Q_EMIT constructionProgressChanged();
+            }
+        }, Qt::QueuedConnection);
+        connect(n, &QSGVtkObjectNode::animationFinished, this, &QQuickVtkItem::animationFinished, Qt::QueuedConnection);
+        connect(n, &QSGVtkObjectNode::snapshotPublished, this, [d, this] {
+            // Cleared first, so a snapshot published from now on notifies again
+            d->snapshots->notifyPending = false;
+            if (d->snapshots->buffer.update()) {
+                d->snapshot = d->snapshots->buffer.front();
+                Q_EMIT snapshotChanged();
+            }
+        }, Qt::QueuedConnection);
+        d->snapshotFunctionChanged = true;
+    }
+
+    // Hand the construction steps over to the node, from then on they run just before each render
+    n->m_constructionBudget = d->constructionBudget;
+    while (!d->incremental.isEmpty()) {
+        d->asyncDispatch.enqueue([n, step = d->incremental.dequeue()](vtkRenderWindow*, vtkUserData) {
+            n->m_steps.enqueue(step);
+        });
+    }
+
+    if (std::exchange(d->snapshotFunctionChanged, false)) {
+        d->asyncDispatch.enqueue([n, function = d->snapshotFunction](vtkRenderWindow*, vtkUserData) {
+            n->m_snapshotFunction = function;
+        });
+    }
+
+    // The animations too, from then on they run just before each render without the gui-thread
+    while (!d->animations.isEmpty()) {
+        d->asyncDispatch.enqueue([n, pending = d->animations.dequeue()](vtkRenderWindow*, vtkUserData) {
+            n->m_animations.append({pending.id, pending.animation, -1});
+        });
+    }
+    for (int id : std::exchange(d->stoppedAnimations, {})) {
+        d->asyncDispatch.enqueue([n, id](vtkRenderWindow*, vtkUserData) {
+            n->removeAnimation(id);
+        });
+    }
+
+    // With threadedRendering everything goes to the VTK render thread and we only pick up its latest frame
+    if (n->m_thread) {
+        n->m_thread->synchronize(this, d->asyncDispatch, std::exchange(d->scheduleRender, false));
+        n->setTextureCoordinatesTransform(QSGSimpleTextureNode::MirrorVertically);
+        n->setFiltering(smooth() ? QSGTexture::Linear : QSGTexture::Nearest);
+        n->setRect(0, 0, width(), height());
+        return n;
     }
 
     // Watch for size changes
@@ -256,6 +1483,7 @@ QSGNode* QQuickVtkItem::updatePaintNode(QSGNode* node, UpdatePaintNodeData*)
     auto sz = size() * n->m_devicePixelRatio;
     bool dirtySize = sz != n->size; 
     if (dirtySize) {
+        QQUICKVTK_TRACE_SCOPE("SetSize", "width", qint64(sz.width()));
         n->vtkWindow->SetSize(sz.width(), sz.height());
         n->vtkWindow->GetInteractor()->SetSize(n->vtkWindow->GetSize());
         delete n->texture();
@@ -264,6 +1492,7 @@ QSGNode* QQuickVtkItem::updatePaintNode(QSGNode* node, UpdatePaintNodeData*)
 
     // Dispatch commands to VTK
     if (d->asyncDispatch.size()) {
+        QQUICKVTK_TRACE_SCOPE("asyncDispatch", "commands", d->asyncDispatch.size());
         n->scheduleRender();
 
         n->vtkWindow->SetReadyForRendering(true);
@@ -274,16 +1503,12 @@ QSGNode* QQuickVtkItem::updatePaintNode(QSGNode* node, UpdatePaintNodeData*)
     
     // Whenever the size changes we need to get a new FBO from VTK so we need to render right now (with the gui-thread blocked) for this one frame.
     if (dirtySize) {
+        QQUICKVTK_TRACE_SCOPE("textureRewrap");
         n->scheduleRender();
         n->render();
         if (auto fb = n->vtkWindow->GetDisplayFramebuffer(); fb && fb->GetNumberOfColorAttachments() > 0) {
             GLuint texId = fb->GetColorAttachmentAsTextureObject(0)->GetHandle();
-#if QT_VERSION < QT_VERSION_CHECK(6,0,0)
-            auto *texture = window()->createTextureFromNativeObject(QQuickWindow::NativeObjectTexture, &texId, 0, sz.toSize(), QQuickWindow::TextureHasAlphaChannel);
-#else
-            auto *texture = QNativeInterface::QSGOpenGLTexture::fromNative(texId, window(), sz.toSize(), QQuickWindow::TextureHasAlphaChannel);
-#endif
-            n->setTexture(texture);
+            n->setTexture(wrapTexture(window(), texId, sz.toSize()));
         } else if (!fb)
             qWarning().nospace() << "QQuickVTKItem.cpp:" << __LINE__ << ", YIKES!!, Render() didn't create a FrameBuffer!?";
         else
@@ -353,6 +1578,7 @@ void QQuickVtkItem::releaseResources()
     // forget about the node. Since it is the node we returned from updatePaintNode
     // it will be managed by the scene graph.
     Q_D(QQuickVtkItem);
+    d->discardCommands();
     d->node = nullptr;
 }
 
@@ -369,6 +1595,7 @@ bool QQuickVtkItem::event(QEvent * ev)
 
     if (!ev)
         return false;
+
 #if QT_VERSION < QT_VERSION_CHECK(6,0,0)
     switch (ev->type())
     {
@@ -377,45 +1604,45 @@ bool QQuickVtkItem::event(QEvent * ev)
     case QEvent::HoverMove:
     {
         auto e = static_cast<QHoverEvent *>(ev);
-        dispatch_async([d, 
+        dispatch_async([adapter = d->qt2vtkInteractorAdapter, 
             e = QHoverEvent(
                 e->type(), 
                 e->posF(),
                 e->oldPosF(), 
                 e->modifiers())]
             (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-                d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+                adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
             });
         break;
     }
     case QEvent::Enter:
     {
       auto e = static_cast<QEnterEvent*>(ev);
-      dispatch_async([d,
+      dispatch_async([adapter = d->qt2vtkInteractorAdapter,
           e = QEnterEvent(
               e->localPos(), 
               e->windowPos(), 
               e->screenPos())]
           (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-              d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+              adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
           });
       break;
     }
     case QEvent::Leave:
     {
       auto e = static_cast<QEvent*>(ev);
-      dispatch_async([d,
+      dispatch_async([adapter = d->qt2vtkInteractorAdapter,
           e = QEvent(
               e->type())]
           (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-              d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+              adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
           });
       break;
     }
     case QEvent::DragEnter:
     {
       auto e = static_cast<QDragEnterEvent*>(ev);
-      dispatch_async([d,
+      dispatch_async([adapter = d->qt2vtkInteractorAdapter,
           e = QDragEnterEvent(
               e->pos(), 
               e->possibleActions(), 
@@ -423,23 +1650,23 @@ bool QQuickVtkItem::event(QEvent * ev)
               e->mouseButtons(),
               e->keyboardModifiers())]
           (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-              d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+              adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
           });
       break;
     }
     case QEvent::DragLeave:
     {
-      dispatch_async([d,
+      dispatch_async([adapter = d->qt2vtkInteractorAdapter,
           e = QDragLeaveEvent()]
           (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-              d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+              adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
           });
       break;
     }
     case QEvent::DragMove:
     {
       auto e = static_cast<QDragMoveEvent*>(ev);
-      dispatch_async([d,
+      dispatch_async([adapter = d->qt2vtkInteractorAdapter,
           e = QDragMoveEvent(
               e->pos(), 
               e->possibleActions(), 
@@ -447,14 +1674,14 @@ bool QQuickVtkItem::event(QEvent * ev)
               e->mouseButtons(),
               e->keyboardModifiers())]
           (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-              d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+              adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
           });
       break;
     }
     case QEvent::Drop:
     {
       auto e = static_cast<QDropEvent*>(ev);
-      dispatch_async([d,
+      dispatch_async([adapter = d->qt2vtkInteractorAdapter,
           e = QDropEvent(
               e->pos(), 
               e->possibleActions(), 
@@ -462,21 +1689,21 @@ bool QQuickVtkItem::event(QEvent * ev)
               e->mouseButtons(),
               e->keyboardModifiers())]
           (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-              d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+              adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
           });
       break;
     }
     case QEvent::ContextMenu:
     {
       auto e = static_cast<QContextMenuEvent*>(ev);
-      dispatch_async([d,
+      dispatch_async([adapter = d->qt2vtkInteractorAdapter,
           e = QContextMenuEvent(
               e->reason(), 
               e->pos(), 
               e->globalPos(),
               e->modifiers())]
           (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-              d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+              adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
           });
       break;
     }
@@ -484,7 +1711,7 @@ bool QQuickVtkItem::event(QEvent * ev)
     case QEvent::KeyRelease:
     {
         auto e = static_cast<QKeyEvent *>(ev);
-        dispatch_async([d, 
+        dispatch_async([adapter = d->qt2vtkInteractorAdapter, 
             e = QKeyEvent(
                 e->type(), 
                 e->key(), 
@@ -496,7 +1723,7 @@ bool QQuickVtkItem::event(QEvent * ev)
                 e->isAutoRepeat(), 
                 e->count())]
             (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-                d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+                adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
             });
         break;
     }
@@ -504,12 +1731,12 @@ bool QQuickVtkItem::event(QEvent * ev)
     case QEvent::FocusOut:
     {
         auto e = static_cast<QFocusEvent *>(ev);
-        dispatch_async([d, 
+        dispatch_async([adapter = d->qt2vtkInteractorAdapter, 
             e = QFocusEvent(
                 e->type(), 
                 e->reason())]
             (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-                d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+                adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
             });
         break;
     }
@@ -519,7 +1746,7 @@ bool QQuickVtkItem::event(QEvent * ev)
     case QEvent::MouseButtonDblClick:
     {
         auto e = static_cast<QMouseEvent *>(ev);
-        dispatch_async([d, 
+        dispatch_async([adapter = d->qt2vtkInteractorAdapter, 
             e = QMouseEvent(
                 e->type(), 
                 e->localPos(),
@@ -530,7 +1757,7 @@ bool QQuickVtkItem::event(QEvent * ev)
                 e->modifiers(),
                 e->source())]
             (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-                d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+                adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
             });        
         break;
     }
@@ -538,7 +1765,7 @@ bool QQuickVtkItem::event(QEvent * ev)
     case QEvent::Wheel:
     {
         auto e = static_cast<QWheelEvent *>(ev);
-        dispatch_async([d, 
+        dispatch_async([adapter = d->qt2vtkInteractorAdapter, 
             e = QWheelEvent(
                 e->position(),
                 e->globalPosition(), 
@@ -550,7 +1777,7 @@ bool QQuickVtkItem::event(QEvent * ev)
                 e->inverted(), 
                 e->source())]
             (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-                d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+                adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
             });
         break;
     }
@@ -562,14 +1789,14 @@ bool QQuickVtkItem::event(QEvent * ev)
     case QEvent::TouchCancel:
     {
         auto e = static_cast<QTouchEvent *>(ev);
-        dispatch_async([d, 
+        dispatch_async([adapter = d->qt2vtkInteractorAdapter, 
             e = QTouchEvent(e->type(),
                 e->device(),
                 e->modifiers(),
                 e->touchPointStates(),
                 e->touchPoints())]
             (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-                d->qt2vtkInteractorAdapter.ProcessEvent(&e, vtkWindow->GetInteractor());
+                adapter->ProcessEvent(&e, vtkWindow->GetInteractor());
             });
         break;
     }
@@ -578,13 +1805,16 @@ bool QQuickVtkItem::event(QEvent * ev)
         return QQuickItem::event(ev);
     }
 #else
-    dispatch_async([d, e = ev->clone()]
-                   (vtkRenderWindow* vtkWindow, vtkUserData) mutable {
-                       d->qt2vtkInteractorAdapter.ProcessEvent(e, vtkWindow->GetInteractor());
-                       delete e;
+    // note: Also released when the command is dropped without running
+    dispatch_async([adapter = d->qt2vtkInteractorAdapter, e = QSharedPointer<QEvent>(ev->clone())]
+                   (vtkRenderWindow* vtkWindow, vtkUserData) {
+                       adapter->ProcessEvent(e.data(), vtkWindow->GetInteractor());
                    });
 
 #endif
+    // Only the events queued for VTK get here
+    QQUICKVTK_TRACE_INSTANT("event", "type", QMetaEnum::fromType<QEvent::Type>().valueToKey(ev->type()));
+
     ev->accept();
 
     return true;
@@ -3,6 +3,12 @@
 #include <QtQuick/QQuickItem>
 
 #include <QtCore/QScopedPointer>
+#include <QtCore/QSize>
+#include <QtCore/QVariantMap>
+#include <QtCore/QVector>
+
+#include <QtGui/QColor>
+#include <QtGui/QVector3D>
 
 #include <vtkSmartPointer.h>
 
@@ -11,11 +17,32 @@
 class vtkRenderWindow;
 class vtkObject;
 
+class QAbstractItemModel;
+
 class QQuickVtkItemPrivate;
 class QQuickVtkItem : public QQuickItem
 {
     Q_OBJECT
 
+    Q_PROPERTY(QAbstractItemModel* model READ model WRITE setModel NOTIFY modelChanged)
+    Q_PROPERTY(QString positionRole READ positionRole WRITE setPositionRole NOTIFY positionRoleChanged)
+    Q_PROPERTY(QString colorRole READ colorRole WRITE setColorRole NOTIFY colorRoleChanged)
+    Q_PROPERTY(QString visibleRole READ visibleRole WRITE setVisibleRole NOTIFY visibleRoleChanged)
+    Q_PROPERTY(bool threadedRendering READ threadedRendering WRITE setThreadedRendering NOTIFY threadedRenderingChanged)
+    Q_PROPERTY(int constructionBudget READ constructionBudget WRITE setConstructionBudget NOTIFY constructionBudgetChanged)
+    Q_PROPERTY(qreal constructionProgress READ constructionProgress NOTIFY constructionProgressChanged)
+    Q_PROPERTY(int frameCount READ frameCount NOTIFY snapshotChanged)
+    Q_PROPERTY(qreal frameTime READ frameTime NOTIFY snapshotChanged)
+    Q_PROPERTY(QVector3D cameraPosition READ cameraPosition NOTIFY snapshotChanged)
+    Q_PROPERTY(QVector3D cameraFocalPoint READ cameraFocalPoint NOTIFY snapshotChanged)
+    Q_PROPERTY(QVector3D cameraViewUp READ cameraViewUp NOTIFY snapshotChanged)
+    Q_PROPERTY(qreal cameraViewAngle READ cameraViewAngle NOTIFY snapshotChanged)
+    Q_PROPERTY(QVector3D sceneBoundsMin READ sceneBoundsMin NOTIFY snapshotChanged)
+    Q_PROPERTY(QVector3D sceneBoundsMax READ sceneBoundsMax NOTIFY snapshotChanged)
+    Q_PROPERTY(int pickedId READ pickedId NOTIFY snapshotChanged)
+    Q_PROPERTY(QVector3D pickedCenter READ pickedCenter NOTIFY snapshotChanged)
+    Q_PROPERTY(int propsRendered READ propsRendered NOTIFY snapshotChanged)
+
 public:
     explicit QQuickVtkItem(QQuickItem* parent = nullptr);
     ~QQuickVtkItem() override;
@@ -25,8 +52,9 @@ public:
     /**
     * This is where the VTK initializiation should be done including creating a pipeline and attaching it to the window
     *
-    * \note All VTK objects are owned by and run on the QML render thread!!  This means you CAN NOT touch any VTK state
-    *       from any place other than in this method or in your dispatch_async() functions!!
+    * \note All VTK objects are owned by and run on the QML render thread, or on the item's own VTK render thread with
+    *       threadedRendering!!  This means you CAN NOT touch any VTK state from any place other than in this method
+    *       or in your dispatch_async() functions!!
     * 
     * \note All VTK objects must be stored in the vtkUserData object returned from this method.
     *       They will be destroyed if the underlaying QSGNode (which must contain all VTK objects) is destroyed.
@@ -49,22 +77,230 @@ public:
     /**
     * This is the function that enqueues an async command that will be executed just before VTK renders
     * 
-    * \note All VTK objects are owned by and run on the QML render thread!!  This means you CAN NOT touch any VTK state
-    *       from any place other than in your function object passed as a parameter here or initializeVTK()!!
+    * \note All VTK objects are owned by and run on the QML render thread, or on the item's own VTK render thread with
+    *       threadedRendering!!  This means you CAN NOT touch any VTK state from any place other than in your function
+    *       object passed as a parameter here or initializeVTK()!!
     *
     * \note This function should only be called from the qt-gui-thread, eg. from a QML button click-handler
     *
     * \note At the time of the async command execution, the GUI thread is blocked. Hence, it is safe to
     * perform state synchronization between the GUI elements and the VTK classes in the async command function.
     *
+    * \note EXCEPT with threadedRendering, where the command runs later on the item's own VTK render thread while the
+    *       GUI thread keeps going.  The command must then NOT touch the item, or any other gui-thread object, and
+    *       must capture everything it needs by value!!  Commands dispatched before a frame are run in order before
+    *       that frame is rendered, but the frame may be shown a few QML frames later.  The commands not run yet
+    *       are dropped when the item is destroyed or releases its resources, the destruction waits for a running one.
+    *
     * \param renderWindow, the VTK render window that creates this object's pixels for display
     * \param userData An optional User Data object associated with the VTK render window
     */
     void dispatch_async(std::function<void(vtkRenderWindow* renderWindow, vtkUserData userData)>);
 
+    /**
+    * This is the function that enqueues a construction step, for building a large scene across many frames
+    *
+    * Just before VTK renders, the pending steps are called over and over for at most constructionBudget milliseconds,
+    * then the partial scene is rendered and the remaining steps continue on the next frame.  So the item shows
+    * something and stays interactive right away, whatever the size of the scene.
+    *
+    * \note Can be called from initializeVTK() to build the scene incrementally, or from the qt-gui-thread
+    *
+    * \note Unlike dispatch_async() commands, the steps run just before VTK renders, on the qt-render-thread (or the
+    *       VTK render thread with threadedRendering) WITHOUT the GUI thread blocked.  So a step must not touch the
+    *       item, or any other gui-thread object, and must capture everything it needs by value!!
+    *
+    * \note Steps not yet finished are dropped with the VTK objects if the underlying QSGNode is destroyed, the
+    *       steps queued by initializeVTK() are then queued again when it is called again
+    *
+    * \param step, does a small chunk of the work and returns the progress of the step, 1.0 (or more) when done
+    */
+    void dispatch_incremental(std::function<double(vtkRenderWindow* renderWindow, vtkUserData userData)> step);
+
+    // The time, in milliseconds, given to the construction steps before each render
+    int constructionBudget() const;
+    void setConstructionBudget(int milliseconds);
+
+    // The progress of all the pending construction steps, 1.0 when there are none and back to 0 when new ones are queued
+    qreal constructionProgress() const;
+
+    /**
+    * An animation, evaluated on the thread that renders VTK just before every frame for as long as it runs
+    *
+    * \note Like the construction steps, the animation runs without the GUI thread blocked, see dispatch_incremental()
+    *
+    * \param seconds, the time since the animation's first frame.  Qt has no vsync timestamp to offer, so it is read
+    *        from a steady clock once per frame, as the frame starts, and is the same for all the animations of a frame.
+    *
+    * \return false when done
+    */
+    using Animation = std::function<bool(double seconds, vtkRenderWindow* renderWindow, vtkUserData userData)>;
+
+    /**
+    * Registers an animation, from then on it runs without any work on the qt-gui-thread
+    *
+    * \note A running animation keeps VTK rendering at the display's frame rate, even with threadedRendering
+    *
+    * \note Animations are dropped with the VTK objects if the underlying QSGNode is destroyed
+    *
+    * \return an id for stopAnimation() and animationFinished()
+    */
+    int animate(Animation animation);
+
+    // A property tween of 'seconds' with an ease in and out, 'apply' is called each frame with the progress from 0 to 1
+    int tween(qreal seconds, std::function<void(double t, vtkRenderWindow* renderWindow, vtkUserData userData)> apply);
+
+    // Orbits the active camera of the first renderer around its focal point, for 'seconds' or forever when 0
+    Q_INVOKABLE int orbitCamera(qreal degreesPerSecond, qreal seconds = 0);
+
+    // Flies the active camera of the first renderer from where it is to 'position' looking at 'focalPoint'
+    Q_INVOKABLE int flyCamera(const QVector3D& position, const QVector3D& focalPoint, qreal seconds);
+
+    // Stops an animation where it is, animationFinished() is not emitted for it
+    Q_INVOKABLE void stopAnimation(int id);
+
+    /**
+    * The state of the VTK side, published by the thread that renders VTK after every frame
+    *
+    * Snapshots go through a lock-free triple buffer, so neither the renders nor the reads ever wait, and the
+    * properties below all come from the same frame.
+    */
+    struct Snapshot
+    {
+        int frame = 0;                      // counts the frames rendered by the current VTK objects
+        double frameTime = 0;               // milliseconds spent in VTK's Render() for this frame
+        QSize size;                         // of the VTK render window, in pixels
+        QVector3D cameraPosition;           // of the active camera of the first renderer
+        QVector3D cameraFocalPoint;
+        QVector3D cameraViewUp;
+        double cameraViewAngle = 30;
+        bool hasBounds = false;             // false while no prop is visible
+        QVector3D boundsMin;                // of the visible props of the first renderer
+        QVector3D boundsMax;
+        int propsRendered = 0;              // by the first renderer
+        int pickedId = -1;                  // filled in by the snapshot function, eg. the index of the picked actor
+        QVector3D pickedCenter;
+        QVariantMap extra;                  // filled in by the snapshot function, for the properties of a derived item
+    };
+
+    // The latest snapshot, on the qt-gui-thread.  Never blocks, it is updated just before snapshotChanged()
+    Snapshot snapshot() const;
+
+    int frameCount() const;
+    qreal frameTime() const;
+    QVector3D cameraPosition() const;
+    QVector3D cameraFocalPoint() const;
+    QVector3D cameraViewUp() const;
+    qreal cameraViewAngle() const;
+    QVector3D sceneBoundsMin() const;
+    QVector3D sceneBoundsMax() const;
+    int pickedId() const;
+    QVector3D pickedCenter() const;
+    int propsRendered() const;
+
+    /**
+    * Adds the item's own state to the snapshots, the function is called after every frame with the rest of the
+    * snapshot already filled in
+    *
+    * \note Called on the thread that renders VTK without the qt-gui-thread blocked, so only touch VTK state (and
+    *       what is captured by value) in there
+    *
+    * \note Set it from the constructor or from initializeVTK()
+    */
+    void setSnapshotFunction(std::function<void(Snapshot& snapshot, vtkRenderWindow* renderWindow, vtkUserData userData)> function);
+
+    /**
+    * When set, VTK renders on a dedicated thread with an OpenGL context shared with the QML render thread.
+    * Finished frames are published as textures guarded by fences and the QML scene graph always composites the
+    * latest one without waiting, so a slow VTK frame no longer slows down the rest of the QML UI.
+    *
+    * \note Takes effect when the underlying QSGNode is (re)created, so set it before the item is first shown
+    *
+    * \note initializeVTK() still runs with the GUI thread blocked, but dispatch_async() commands, construction steps,
+    *       animations and the snapshot function do not: they run on the VTK render thread while the GUI thread
+    *       keeps going, so they must not touch the item (see dispatch_async())
+    *
+    * \note Falls back to rendering on the QML render thread, with a warning, when the shared OpenGL context can't
+    *       be created or made current
+    *
+    * \note The interactor lives on the VTK render thread and its timers fire there between frames, each one renders a
+    *       frame after it so that what its observers change shows up
+    */
+    bool threadedRendering() const;
+    void setThreadedRendering(bool threaded);
+
+    /**
+    * The rows of the model are the scene objects, read through the position (QVector3D), color (QColor)
+    * and visible (bool) roles.  Only the top-level rows of the model are used.
+    */
+    QAbstractItemModel* model() const;
+    void setModel(QAbstractItemModel* model);
+    QString positionRole() const;
+    void setPositionRole(const QString& role);
+    QString colorRole() const;
+    void setColorRole(const QString& role);
+    QString visibleRole() const;
+    void setVisibleRole(const QString& role);
+
+    /**
+    * All the changes of the model since the previous frame.  Apply 'ops' in order, then 'changed' whose
+    * row numbers are in the final numbering and whose values have already been read from the model.
+    * Inserted rows are always reported in 'changed' with all their roles.
+    */
+    struct ModelUpdate
+    {
+        enum Role { PositionRole = 0x1, ColorRole = 0x2, VisibleRole = 0x4, AllRoles = 0x7 };
+
+        struct Op
+        {
+            enum Type { Insert, Remove } type;
+            int first;
+            int count;
+        };
+
+        struct Changed
+        {
+            int first;
+            int count;
+            int roles;                      // the roles that have values below
+            QVector<QVector3D> positions;
+            QVector<QColor> colors;
+            QVector<bool> visible;
+        };
+
+        bool reset = false;                 // when set, 'ops' is empty and 'changed' covers all rows
+        int rowCount = 0;
+        QVector<Op> ops;
+        QVector<Changed> changed;
+    };
+
+Q_SIGNALS:
+    void threadedRenderingChanged();
+    void constructionBudgetChanged();
+    void constructionProgressChanged();
+    void animationFinished(int id);
+    void snapshotChanged();
+    void modelChanged();
+    void positionRoleChanged();
+    void colorRoleChanged();
+    void visibleRoleChanged();
+
+protected:
+    /**
+    * Called on the qt-gui-thread, at most once per frame, with the batched changes of the model
+    *
+    * \note Forward the changes to VTK with a single dispatch_async(), this keeps the cost of a frame proportional
+    *       to the size of the change rather than to the size of the model.
+    */
+    virtual void modelUpdated(const ModelUpdate& update) { Q_UNUSED(update) }
+
 protected:
     void scheduleRender();
 
+protected:
+    void updatePolish() override;
+    void itemChange(ItemChange change, const ItemChangeData& value) override;
+
 protected:
     bool event(QEvent*) override;
 
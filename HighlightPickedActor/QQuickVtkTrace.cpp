@@ -0,0 +1,238 @@
+#include "QQuickVtkTrace.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QThread>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace QQuickVtkTrace {
+
+namespace {
+
+struct Event
+{
+    const char* name;
+    const char* argName;
+    const char* argString;      // used by instant events
+    std::int64_t arg;
+    std::int64_t ts;            // microseconds since start()
+    std::int64_t dur;           // -1 for instant events
+};
+
+// One per thread and per trace, so recording only ever contends with the final write out
+struct ThreadBuffer
+{
+    std::mutex mutex;
+    std::vector<Event> events;
+    std::string threadName;
+    int tid = 0;
+    int generation = 0;         // of the trace it belongs to
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::string fileName;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::atomic<int> generation{0};     // moves on at every start() and stop()
+};
+
+Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+
+std::string currentThreadName()
+{
+    auto thread = QThread::currentThread();
+    if (!thread)
+        return "thread";
+    if (!thread->objectName().isEmpty())
+        return thread->objectName().toStdString();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+        return "qt-gui-thread";
+    // eg. QSGRenderThread for the Qt Quick render thread
+    return thread->metaObject()->className();
+}
+
+// The buffer of this thread for the current trace, nullptr once the trace is stopped
+ThreadBuffer* threadBuffer()
+{
+    // Re-register when tracing restarts, the registry drops its buffers on stop()
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+
+    auto& r = registry();
+    if (buffer && buffer->generation == r.generation.load())
+        return buffer.get();
+
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (!detail::enabled)
+        return nullptr;
+    if (!buffer || buffer->generation != r.generation) {
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->threadName = currentThreadName();
+        buffer->tid = static_cast<int>(r.buffers.size()) + 1;
+        buffer->generation = r.generation;
+        r.buffers.push_back(buffer);
+    }
+    return buffer.get();
+}
+
+void record(const Event& e)
+{
+    auto buffer = threadBuffer();
+    if (!buffer)
+        return;
+
+    // stop() moves the generation on before it writes the buffers out, so an event is either written or dropped
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    if (buffer->generation != registry().generation.load())
+        return;
+    buffer->events.push_back(e);
+}
+
+void writeString(std::FILE* f, const char* s)
+{
+    std::fputc('"', f);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\')
+            std::fputc('\\', f);
+        std::fputc(*s, f);
+    }
+    std::fputc('"', f);
+}
+
+// Also writes the trace at exit, it is constructed after (and so destroyed before) the registry
+struct EnvironmentStart
+{
+    EnvironmentStart()
+    {
+        registry();
+        if (auto fileName = std::getenv("QQUICKVTKITEM_TRACE"); fileName && *fileName)
+            start(fileName);
+    }
+
+    ~EnvironmentStart() { stop(); }
+} environmentStart;
+
+} // namespace
+
+namespace detail {
+
+std::atomic<bool> enabled{false};
+
+std::int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - registry().epoch).count();
+}
+
+void complete(const char* name, std::int64_t start, const char* argName, std::int64_t arg)
+{
+    // Tracing may have been stopped while the span was open
+    if (!isEnabled())
+        return;
+    record(Event{name, argName, nullptr, arg, start, now() - start});
+}
+
+} // namespace detail
+
+void start(const char* fileName)
+{
+    auto& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (detail::enabled)
+            return;
+        r.fileName = fileName;
+        r.epoch = std::chrono::steady_clock::now();
+        r.buffers.clear();
+        ++r.generation;
+        detail::enabled = true;
+    }
+}
+
+void stop()
+{
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (!detail::enabled)
+        return;
+    detail::enabled = false;
+    ++r.generation;
+
+    // The threads still hold their buffers until they next record, don't keep the events alive with them
+    auto releaseBuffers = [&r] {
+        for (auto const& buffer : r.buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            buffer->events = {};
+        }
+        r.buffers.clear();
+    };
+
+    auto f = std::fopen(r.fileName.c_str(), "w");
+    if (!f) {
+        std::fprintf(stderr, "QQuickVtkTrace: can not write %s\n", r.fileName.c_str());
+        releaseBuffers();
+        return;
+    }
+
+    std::fputs("{\"traceEvents\":[\n", f);
+    bool first = true;
+    auto separator = [&first, f] {
+        if (!first)
+            std::fputs(",\n", f);
+        first = false;
+    };
+    for (auto const& buffer : r.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+        separator();
+        std::fprintf(f, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", buffer->tid);
+        writeString(f, buffer->threadName.c_str());
+        std::fputs("}}", f);
+
+        for (auto const& e : buffer->events) {
+            separator();
+            std::fputs("{\"name\":", f);
+            writeString(f, e.name);
+            if (e.dur >= 0)
+                std::fprintf(f, ",\"cat\":\"qquickvtk\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d",
+                             static_cast<long long>(e.ts), static_cast<long long>(e.dur), buffer->tid);
+            else
+                std::fprintf(f, ",\"cat\":\"qquickvtk\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lld,\"pid\":1,\"tid\":%d",
+                             static_cast<long long>(e.ts), buffer->tid);
+            if (e.argName) {
+                std::fputs(",\"args\":{", f);
+                writeString(f, e.argName);
+                std::fputc(':', f);
+                if (e.argString)
+                    writeString(f, e.argString);
+                else
+                    std::fprintf(f, "%lld", static_cast<long long>(e.arg));
+                std::fputc('}', f);
+            }
+            std::fputc('}', f);
+        }
+    }
+    std::fputs("\n]}\n", f);
+    std::fclose(f);
+
+    releaseBuffers();
+}
+
+void instant(const char* name, const char* argName, const char* argValue)
+{
+    if (!isEnabled())
+        return;
+    record(Event{name, argValue ? argName : nullptr, argValue, 0, detail::now(), -1});
+}
+
+} // namespace QQuickVtkTrace
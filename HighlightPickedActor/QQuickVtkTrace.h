@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+* Timeline tracing of the QQuickVtkItem threads in the Chrome/Perfetto trace-event JSON format
+*
+* Tracing is off by default.  Set QQUICKVTKITEM_TRACE=<file.json> in the environment, or call start(), and the trace
+* is written out by stop() or at exit.  Open it in chrome://tracing or https://ui.perfetto.dev
+*
+* \note When tracing is off a span costs one relaxed atomic load.  Define QQUICKVTK_NO_TRACE to compile it out.
+*
+* \note Names and argument names must be string literals (or otherwise outlive the trace)
+*/
+namespace QQuickVtkTrace {
+
+namespace detail {
+extern std::atomic<bool> enabled;
+std::int64_t now();
+void complete(const char* name, std::int64_t start, const char* argName, std::int64_t arg);
+}
+
+inline bool isEnabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+void start(const char* fileName);
+void stop();
+
+// A zero-duration marker on the current thread's timeline
+void instant(const char* name, const char* argName = nullptr, const char* argValue = nullptr);
+
+// A span on the current thread's timeline, from construction to destruction
+class Scope
+{
+public:
+    explicit Scope(const char* name, const char* argName = nullptr, std::int64_t arg = 0)
+        : m_name(isEnabled() ? name : nullptr), m_argName(argName), m_arg(arg)
+    {
+        if (m_name)
+            m_start = detail::now();
+    }
+
+    ~Scope()
+    {
+        if (m_name)
+            detail::complete(m_name, m_start, m_argName, m_arg);
+    }
+
+    void setArg(std::int64_t arg) { m_arg = arg; }
+
+private:
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    const char* m_name;
+    const char* m_argName;
+    std::int64_t m_arg;
+    std::int64_t m_start = 0;
+};
+
+} // namespace QQuickVtkTrace
+
+#define QQUICKVTK_TRACE_CONCAT_(a, b) a##b
+#define QQUICKVTK_TRACE_CONCAT(a, b) QQUICKVTK_TRACE_CONCAT_(a, b)
+
+#ifndef QQUICKVTK_NO_TRACE
+#define QQUICKVTK_TRACE_SCOPE(...) QQuickVtkTrace::Scope QQUICKVTK_TRACE_CONCAT(qquickvtk_trace_, __LINE__)(__VA_ARGS__)
+#define QQUICKVTK_TRACE_INSTANT(...) do { if (QQuickVtkTrace::isEnabled()) QQuickVtkTrace::instant(__VA_ARGS__); } while (0)
+#else
+#define QQUICKVTK_TRACE_SCOPE(...) do {} while (0)
+#define QQUICKVTK_TRACE_INSTANT(...) do {} while (0)
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+
+/**
+* A lock-free triple buffer: one thread keeps publishing values, another one keeps reading the latest of them.
+*
+* Neither side ever waits for the other.  The writer fills back() then publish()es it, the reader calls update()
+* and then reads front(), which stays unchanged until its next update().
+*
+* \note Exactly one writer thread and one reader thread
+*/
+template<class T>
+class QQuickVtkTripleBuffer
+{
+public:
+    // Writer side
+    T& back() { return m_buffers[m_back]; }
+
+    void publish()
+    {
+        m_back = m_middle.exchange(m_back | Fresh, std::memory_order_acq_rel) & Index;
+    }
+
+    // Reader side, returns true if front() is now a newer value
+    bool update()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & Fresh))
+            return false;
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & Index;
+        return true;
+    }
+
+    const T& front() const { return m_buffers[m_front]; }
+
+private:
+    enum { Index = 0x3, Fresh = 0x4 };
+
+    T m_buffers[3];
+    int m_back = 0;
+    std::atomic<int> m_middle{1};       // the index of the latest published buffer, and whether the reader has seen it
+    int m_front = 2;
+};
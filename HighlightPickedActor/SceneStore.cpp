@@ -0,0 +1,214 @@
+#include "SceneStore.h"
+
+#include <algorithm>
+#include <cstring>
+
+void SceneStore::DirtyRanges::add(int begin, int end)
+{
+    if (begin >= end)
+        return;
+
+    // Insert sorted by begin, then merge overlapping or adjacent ranges
+    auto it = std::lower_bound(m_ranges.begin(), m_ranges.end(), begin,
+        [](const Range& r, int b) { return r.begin < b; });
+    m_ranges.insert(it, Range{begin, end});
+
+    // The list never holds more than MaxRanges+1 entries so a linear pass is fine
+    std::vector<Range> merged;
+    merged.reserve(m_ranges.size());
+    for (auto const& r : m_ranges) {
+        if (!merged.empty() && r.begin <= merged.back().end)
+            merged.back().end = std::max(merged.back().end, r.end);
+        else
+            merged.push_back(r);
+    }
+    m_ranges.swap(merged);
+
+    if (static_cast<int>(m_ranges.size()) > MaxRanges) {
+        Range bounds{m_ranges.front().begin, m_ranges.back().end};
+        m_ranges.assign(1, bounds);
+    }
+}
+
+void SceneStore::DirtyRanges::insert(int index, int count)
+{
+    // Split the range the insertion falls into, the inserted objects themselves are added by the caller
+    std::vector<Range> shifted;
+    shifted.reserve(m_ranges.size() + 1);
+    for (auto r : m_ranges) {
+        if (r.begin >= index) {
+            shifted.push_back({r.begin + count, r.end + count});
+        } else if (r.end > index) {
+            shifted.push_back({r.begin, index});
+            shifted.push_back({index + count, r.end + count});
+        } else {
+            shifted.push_back(r);
+        }
+    }
+    m_ranges.clear();
+    for (auto const& r : shifted)
+        add(r.begin, r.end);
+}
+
+void SceneStore::DirtyRanges::remove(int index, int count)
+{
+    std::vector<Range> shifted;
+    shifted.reserve(m_ranges.size() + 1);
+    for (auto const& r : m_ranges) {
+        if (r.begin < index)
+            shifted.push_back({r.begin, std::min(r.end, index)});
+        if (r.end > index + count) {
+            const int begin = std::max(r.begin, index + count);
+            shifted.push_back({begin - count, r.end - count});
+        }
+    }
+    m_ranges.clear();
+    for (auto const& r : shifted)
+        add(r.begin, r.end);
+}
+
+void SceneStore::resize(int count)
+{
+    count = std::max(count, 0);
+    if (count > m_count)
+        insert(m_count, count - m_count);
+    else if (count < m_count)
+        remove(count, m_count - count);
+}
+
+void SceneStore::insert(int index, int count)
+{
+    index = std::clamp(index, 0, m_count);
+    if (count <= 0)
+        return;
+
+    m_positions.insert(m_positions.begin() + 3 * index, 3 * count, 0.f);
+    m_scales.insert(m_scales.begin() + index, count, 1.f);
+    m_colors.insert(m_colors.begin() + 4 * index, 4 * count, 255);
+    m_visible.insert(m_visible.begin() + index, count, 1);
+
+    m_count += count;
+    m_countChanged = true;
+
+    // The objects after the insertion point are shifted by the render thread, only the new ones are copied
+    m_ops.push_back({Op::Insert, index, count});
+    for (auto& d : m_dirty)
+        d.insert(index, count);
+    markDirty(index, index + count);
+}
+
+void SceneStore::remove(int index, int count)
+{
+    index = std::clamp(index, 0, m_count);
+    count = std::clamp(count, 0, m_count - index);
+    if (count <= 0)
+        return;
+
+    m_positions.erase(m_positions.begin() + 3 * index, m_positions.begin() + 3 * (index + count));
+    m_scales.erase(m_scales.begin() + index, m_scales.begin() + index + count);
+    m_colors.erase(m_colors.begin() + 4 * index, m_colors.begin() + 4 * (index + count));
+    m_visible.erase(m_visible.begin() + index, m_visible.begin() + index + count);
+
+    m_count -= count;
+    m_countChanged = true;
+
+    m_ops.push_back({Op::Remove, index, count});
+    for (auto& d : m_dirty)
+        d.remove(index, count);
+}
+
+int SceneStore::clampedCount(int first, int count) const
+{
+    if (first < 0 || first >= m_count || count <= 0)
+        return 0;
+    return std::min(count, m_count - first);
+}
+
+void SceneStore::setPositions(int first, const float* xyz, int count)
+{
+    count = clampedCount(first, count);
+    if (!count)
+        return;
+    std::memcpy(m_positions.data() + 3 * first, xyz, 3 * count * sizeof(float));
+    m_dirty[Position].add(first, first + count);
+}
+
+void SceneStore::setScales(int first, const float* scales, int count)
+{
+    count = clampedCount(first, count);
+    if (!count)
+        return;
+    std::memcpy(m_scales.data() + first, scales, count * sizeof(float));
+    m_dirty[Scale].add(first, first + count);
+}
+
+void SceneStore::setColors(int first, const std::uint8_t* rgba, int count)
+{
+    count = clampedCount(first, count);
+    if (!count)
+        return;
+    std::memcpy(m_colors.data() + 4 * first, rgba, 4 * count);
+    m_dirty[Color].add(first, first + count);
+}
+
+void SceneStore::setVisibilities(int first, const std::uint8_t* visible, int count)
+{
+    count = clampedCount(first, count);
+    if (!count)
+        return;
+    std::memcpy(m_visible.data() + first, visible, count);
+    m_dirty[Visibility].add(first, first + count);
+}
+
+bool SceneStore::isDirty() const
+{
+    if (m_countChanged)
+        return true;
+    for (auto const& d : m_dirty)
+        if (!d.isEmpty())
+            return true;
+    return false;
+}
+
+void SceneStore::markAllDirty()
+{
+    // For a new copy, which has nothing to shift
+    m_ops.clear();
+    markDirty(0, m_count);
+    m_countChanged = true;
+}
+
+void SceneStore::clearDirty()
+{
+    for (auto& d : m_dirty)
+        d.clear();
+    m_ops.clear();
+    m_countChanged = false;
+}
+
+void SceneStore::markDirty(int begin, int end)
+{
+    for (auto& d : m_dirty)
+        d.add(begin, end);
+}
+
+SceneStore::Changes SceneStore::takeChanges()
+{
+    Changes c;
+    c.count = m_count;
+    c.countChanged = m_countChanged;
+    c.ops = m_ops;
+
+    auto pack = [this, &c](Attribute a, auto const& src, auto& dst, int comps) {
+        c.ranges[a] = m_dirty[a].ranges();
+        for (auto const& r : c.ranges[a])
+            dst.insert(dst.end(), src.begin() + comps * r.begin, src.begin() + comps * r.end);
+    };
+    pack(Position, m_positions, c.positions, 3);
+    pack(Scale, m_scales, c.scales, 1);
+    pack(Color, m_colors, c.colors, 4);
+    pack(Visibility, m_visible, c.visibilities, 1);
+
+    clearDirty();
+    return c;
+}
@@ -0,0 +1,109 @@
+#ifndef SCENESTORE_H
+#define SCENESTORE_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+* A structure-of-arrays store for many small scene objects (position, scale, color and visibility).
+*
+* \note The store lives on the qt-gui-thread.  It only records which index ranges changed since the
+*       last upload.  takeChanges() copies the changed ranges out so they can be handed over to the render thread
+*       in a single dispatch_async() per frame.
+*/
+class SceneStore
+{
+public:
+    struct Range
+    {
+        int begin;
+        int end; // one past the last index
+    };
+
+    class DirtyRanges
+    {
+    public:
+        void add(int begin, int end);
+        // Renumbers the ranges for 'count' objects inserted at, or removed from, 'index'
+        void insert(int index, int count);
+        void remove(int index, int count);
+        void clear() { m_ranges.clear(); }
+        bool isEmpty() const { return m_ranges.empty(); }
+        const std::vector<Range>& ranges() const { return m_ranges; }
+
+    private:
+        // Beyond this many disjoint ranges, copying the bounding range is cheaper than tracking them
+        static constexpr int MaxRanges = 16;
+        std::vector<Range> m_ranges;
+    };
+
+    enum Attribute { Position, Scale, Color, Visibility, AttributeCount };
+
+    // Objects inserted or removed, the copy on the render thread shifts its arrays in place rather than re-uploading them
+    struct Op
+    {
+        enum Type { Insert, Remove } type;
+        int index;
+        int count;
+    };
+
+    /**
+    * The changes since the last call, apply 'ops' in order, then copy the changed ranges of every attribute whose
+    * values are packed in range order.  Inserted objects are always in the changed ranges.
+    *
+    * \note After markAllDirty() there are no ops, the copy is resized to 'count' and every object is in the ranges
+    */
+    struct Changes
+    {
+        int count = 0;
+        bool countChanged = false;
+        std::vector<Op> ops;
+        std::vector<Range> ranges[AttributeCount];
+        std::vector<float> positions;
+        std::vector<float> scales;
+        std::vector<std::uint8_t> colors;
+        std::vector<std::uint8_t> visibilities;
+    };
+
+    int count() const { return m_count; }
+    void resize(int count);
+    void insert(int index, int count);
+    void remove(int index, int count);
+
+    // Bulk setters, 'count' is the number of objects (not the number of scalars)
+    void setPositions(int first, const float* xyz, int count);
+    void setScales(int first, const float* scales, int count);
+    void setColors(int first, const std::uint8_t* rgba, int count);
+    void setVisibilities(int first, const std::uint8_t* visible, int count);
+
+    const float* positions() const { return m_positions.data(); }
+    const float* scales() const { return m_scales.data(); }
+    const std::uint8_t* colors() const { return m_colors.data(); }
+    const std::uint8_t* visibilities() const { return m_visible.data(); }
+
+    const DirtyRanges& dirty(Attribute a) const { return m_dirty[a]; }
+    bool isDirty() const;
+    void markAllDirty();
+    void clearDirty();
+
+    // Copy out everything that changed since the last call and clear the dirty state
+    Changes takeChanges();
+
+    // True when the number of objects changed since the last clearDirty()
+    bool countChanged() const { return m_countChanged; }
+
+private:
+    int clampedCount(int first, int count) const;
+    void markDirty(int begin, int end);
+
+    int m_count = 0;
+    bool m_countChanged = false;
+    std::vector<Op> m_ops;
+    std::vector<float> m_positions;        // 3 per object
+    std::vector<float> m_scales;           // 1 per object
+    std::vector<std::uint8_t> m_colors;    // 4 per object, rgba
+    std::vector<std::uint8_t> m_visible;   // 1 per object
+    DirtyRanges m_dirty[AttributeCount];
+};
+
+#endif // SCENESTORE_H
@@ -17,11 +17,31 @@ Window {
     }
 
     Vtk.MyVtkItem {
+        id: vtkItem
         anchors.fill: parent
         anchors.margins: 10
         opacity: 0.7
     }
 
+    Text {
+      anchors.left: parent.left
+      anchors.bottom: parent.bottom
+      anchors.margins: 20
+      visible: vtkItem.constructionProgress < 1
+      text: qsTr("Building scene... %1%").arg(Math.round(vtkItem.constructionProgress * 100))
+    }
+
+    Text {
+      anchors.right: parent.right
+      anchors.bottom: parent.bottom
+      anchors.margins: 20
+      text: qsTr("%1 ms, %2 drawn, %3 culled in %4 ms%5").arg(vtkItem.frameTime.toFixed(1))
+                                                          .arg(vtkItem.propsRendered)
+                                                          .arg(vtkItem.propsCulled + vtkItem.propsOccluded)
+                                                          .arg(vtkItem.cullTime.toFixed(2))
+                                                          .arg(vtkItem.pickedId >= 0 ? qsTr(", sphere %1").arg(vtkItem.pickedId) : "")
+    }
+
     Rectangle {
       anchors.centerIn: parent
       width: 50